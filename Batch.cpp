@@ -0,0 +1,165 @@
+// Batch.cpp: Batch Query Mode
+// Runs many OD queries on the shared read-only graph across a pool of threads.
+// Each worker keeps its own search state (threadWorkspace), and results are written in input order.
+#include <bits/stdc++.h>
+using namespace std;
+
+// Problem Presets (shared with the interactive runP* drivers)
+struct ProblemSpec
+{
+    bool time_dependent;
+    bool opt_cost;
+    int target; // time-dependent only: 0 = Cost, 1 = Time
+    map<EdgeType, double> rates, speeds;
+    vector<EdgeType> modes;
+};
+
+ProblemSpec problemSpec(int pid)
+{
+    const vector<EdgeType> all = {ROAD, METRO, BUS_BIKOLPO, BUS_UTTARA, WALKING};
+    const map<EdgeType, double> fares = {{ROAD, 20}, {METRO, 5}, {BUS_BIKOLPO, 7}, {BUS_UTTARA, 7}, {WALKING, 0}};
+    switch (pid)
+    {
+    case 1:
+        return {false, false, 0, {{ROAD, 1}}, {}, {ROAD}};
+    case 2:
+        return {false, true, 0, {{ROAD, 20}, {METRO, 5}, {WALKING, 0}}, {}, {ROAD, METRO, WALKING}};
+    case 3:
+        return {false, true, 0, fares, {}, all};
+    case 4:
+        return {true, true, 0, fares, {{ROAD, 30}, {METRO, 30}, {BUS_BIKOLPO, 30}, {BUS_UTTARA, 30}, {WALKING, 2}}, all};
+    case 5:
+        return {true, true, 1, fares, {{ROAD, 10}, {METRO, 10}, {BUS_BIKOLPO, 10}, {BUS_UTTARA, 10}, {WALKING, 2}}, all};
+    default:
+        throw invalid_argument("unknown problem " + to_string(pid));
+    }
+}
+
+// Solve one preset between graph nodes; ch (optional) replaces Dijkstra for the static problems
+SolutionPath solveProblem(int pid, int s, int e, double start_time, const ContractionHierarchy *ch = nullptr)
+{
+    ProblemSpec spec = problemSpec(pid);
+    if (spec.time_dependent)
+        return dijkstra_time_dependent(s, e, start_time, spec.target, spec.rates, spec.speeds, spec.modes, pid);
+    if (ch)
+        return chQuery(*ch, s, e, spec.rates);
+    return dijkstra_standard(s, e, spec.opt_cost, spec.rates, spec.modes);
+}
+
+// Batch Queries
+// One query per line: <problem 1-5> <src_lat> <src_lon> <dst_lat> <dst_lon> <start HH:MM> <deadline HH:MM>
+// Blank lines and lines starting with '#' are skipped.
+struct BatchQuery
+{
+    int line;
+    int pid;
+    double sLat, sLon, eLat, eLon;
+    double start, deadline; // hours
+    bool valid;
+};
+
+// Static problems only pay for a hierarchy once they have this many queries
+const int CH_MIN_QUERIES = 1000;
+
+bool parseClock(const string &s, double &hours)
+{
+    int h, m;
+    char colon;
+    istringstream in(s);
+    if (!(in >> h >> colon >> m) || colon != ':' || h < 0 || h > 24 || m < 0 || m > 59)
+        return false;
+    hours = h + m / 60.0;
+    return true;
+}
+
+string clockString(double h)
+{
+    int minutes = (int)floor(h * 60 + 0.5);
+    ostringstream out;
+    out << setfill('0') << setw(2) << minutes / 60 << ":" << setw(2) << minutes % 60;
+    return out.str();
+}
+
+vector<BatchQuery> readBatchQueries(istream &in)
+{
+    vector<BatchQuery> queries;
+    string line;
+    for (int lineNo = 1; getline(in, line); lineNo++)
+    {
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == string::npos || line[first] == '#')
+            continue;
+        BatchQuery q{lineNo, 0, 0, 0, 0, 0, 0, 0, false};
+        istringstream ss(line);
+        string start, deadline;
+        q.valid = (ss >> q.pid >> q.sLat >> q.sLon >> q.eLat >> q.eLon >> start >> deadline) &&
+                  q.pid >= 1 && q.pid <= 5 && parseClock(start, q.start) && parseClock(deadline, q.deadline);
+        queries.push_back(q);
+    }
+    return queries;
+}
+
+string runBatchQuery(const BatchQuery &q, const ContractionHierarchy *ch)
+{
+    ostringstream row;
+    row << q.line << "," << q.pid << ",";
+    if (!q.valid)
+        return row.str() + "-,-,invalid,0,0,0,-,-";
+
+    STAT(auto t0 = chrono::steady_clock::now();)
+    int s = getNearestNode(q.sLat, q.sLon);
+    int e = getNearestNode(q.eLat, q.eLon);
+    STAT(double snapMs = msSince(t0);)
+    if (s == -1 || e == -1)
+        return row.str() + "-,-,no_node,0,0,0,-,-";
+
+    double walkSrc = getDistance(q.sLat, q.sLon, nodes[s].lat, nodes[s].lon);
+    double walkDst = getDistance(nodes[e].lat, nodes[e].lon, q.eLat, q.eLon);
+    double gStart = q.start + walkSrc / 2.0;
+    SolutionPath p = solveProblem(q.pid, s, e, gStart, ch);
+    STAT(p.stats.snap_ms = snapMs;
+         cerr << statsRecord("line=" + to_string(q.line) + " problem=" + to_string(q.pid), p.stats);)
+
+    row << originalId(s) << "," << originalId(e) << "," << (p.nodes.empty() ? "no_path" : "ok") << "," << p.edges.size() << ","
+        << fixed << setprecision(6) << p.total_dist << "," << p.total_cost << ",";
+    if (p.nodes.empty() || !problemSpec(q.pid).time_dependent)
+        row << "-,-";
+    else
+    {
+        double arrive = gStart + p.total_time + walkDst / 2.0;
+        row << clockString(arrive) << "," << (arrive <= q.deadline + 1e-9 ? "yes" : "no");
+    }
+    return row.str();
+}
+
+// Results: line,problem,start_node,end_node,status,edges,dist_km,cost_tk,arrival,on_time
+void runBatch(istream &in, ostream &out, int threads)
+{
+    vector<BatchQuery> queries = readBatchQueries(in);
+
+    // Hierarchies are built up front so workers only ever read them
+    shared_ptr<const ContractionHierarchy> ch[6];
+    int perProblem[6] = {};
+    for (const auto &q : queries)
+        if (q.valid)
+            perProblem[q.pid]++;
+    for (int pid = 1; pid <= 3; pid++)
+        if (perProblem[pid] >= CH_MIN_QUERIES)
+        {
+            ProblemSpec spec = problemSpec(pid);
+            ch[pid] = buildContractionHierarchy(spec.opt_cost, spec.rates, spec.modes);
+        }
+
+    vector<string> results(queries.size());
+    auto t0 = chrono::steady_clock::now();
+    parallelFor(queries.size(), threads, [&](size_t i)
+                { results[i] = runBatchQuery(queries[i], queries[i].valid ? ch[queries[i].pid].get() : nullptr); });
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    out << "line,problem,start_node,end_node,status,edges,dist_km,cost_tk,arrival,on_time\n";
+    for (const auto &r : results)
+        out << r << "\n";
+    out.flush();
+    cerr << "Batch: " << queries.size() << " queries on " << threads << " threads in " << fixed << setprecision(3)
+         << secs << " s (" << (secs > 0 ? queries.size() / secs : 0) << " q/s)" << endl;
+}
@@ -0,0 +1,164 @@
+// Benchmark.cpp: Benchmark Driver (g++ -O2 -std=c++17 -pthread Benchmark.cpp -o bench)
+// Times the load phases, then runs every solver on the same seeded OD workload. Results are CSV rows
+// so runs from different versions can be diffed or plotted directly.
+
+#include "DataLoader.cpp"
+#include "NodeOrder.cpp"
+#include "Snapshot.cpp"
+#include "Solver.cpp"
+#include "Raptor.cpp" // owns a graph cache that clearGraphCaches() resets
+#include "ContractionHierarchy.cpp"
+#include "Batch.cpp"
+
+struct BenchQuery
+{
+    int s, e;
+    double start; // hours
+};
+
+// Seeded workload: uniform node pairs, departures uniform over the service day (06:00 - 22:00).
+// Pairs are drawn as load-order ids, so every --order runs the same queries.
+vector<BenchQuery> makeWorkload(size_t count, uint32_t seed)
+{
+    mt19937 rng(seed);
+    uniform_int_distribution<int> node(0, (int)nodes.size() - 1);
+    uniform_int_distribution<int> minute(6 * 60, 22 * 60);
+    vector<BenchQuery> queries;
+    for (size_t i = 0; i < count; i++)
+    {
+        int s = nodeOfOriginalId(node(rng)), e = nodeOfOriginalId(node(rng));
+        queries.push_back({s, e, minute(rng) / 60.0});
+    }
+    return queries;
+}
+
+double percentile(vector<double> sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    size_t k = (size_t)ceil(p / 100 * sorted.size());
+    return sorted[min(sorted.size(), max<size_t>(k, 1)) - 1];
+}
+
+// Rows: kind,name,count,found,total_ms,qps,mean_ms,p50_ms,p95_ms,p99_ms,max_ms
+void report(ostream &out, const string &kind, const string &name, vector<double> ms, size_t found)
+{
+    sort(ms.begin(), ms.end());
+    double total = accumulate(ms.begin(), ms.end(), 0.0);
+    out << kind << "," << name << "," << ms.size() << "," << found << "," << fixed << setprecision(3) << total << ","
+        << (total > 0 ? ms.size() * 1000.0 / total : 0) << "," << (ms.empty() ? 0 : total / ms.size()) << ","
+        << percentile(ms, 50) << "," << percentile(ms, 95) << "," << percentile(ms, 99) << ","
+        << (ms.empty() ? 0 : ms.back()) << endl;
+}
+
+template <typename Fn>
+double timeMs(Fn fn)
+{
+    auto t0 = chrono::steady_clock::now();
+    fn();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+}
+
+// Every solver on the workload with one queue type; rows are named <solver>/<queue>
+template <typename Queue>
+void runQueries(ostream &out, const vector<BenchQuery> &queries, const string &queue)
+{
+    struct Config
+    {
+        string name;
+        int pid;
+    };
+    const vector<Config> configs = {{"dijkstra_standard_p1", 1}, {"dijkstra_standard_p2", 2}, {"dijkstra_standard_p3", 3},
+                                    {"dijkstra_time_dependent_cost", 4}, {"dijkstra_time_dependent_time", 5}};
+    for (const auto &c : configs)
+    {
+        ProblemSpec spec = problemSpec(c.pid);
+        auto run = [&](const BenchQuery &q)
+        {
+            if (spec.time_dependent)
+                return dijkstra_time_dependent<Queue>(q.s, q.e, q.start, spec.target, spec.rates, spec.speeds, spec.modes,
+                                                      c.pid);
+            return dijkstra_standard<Queue>(q.s, q.e, spec.opt_cost, spec.rates, spec.modes);
+        };
+        for (size_t i = 0; i < min<size_t>(10, queries.size()); i++) // warm the workspace and caches
+            run(queries[i]);
+
+        vector<double> ms;
+        size_t found = 0;
+        for (const auto &q : queries)
+            ms.push_back(timeMs([&] { found += !run(q).nodes.empty(); }));
+        report(out, "query", c.name + "/" + queue, ms, found);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t count = 1000;
+    uint32_t seed = 1;
+    int threads = defaultThreadCount();
+    NodeOrder order = ORDER_HILBERT;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--queries" && i + 1 < argc)
+            count = max(1, atoi(argv[++i]));
+        else if (arg == "--seed" && i + 1 < argc)
+            seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--threads" && i + 1 < argc)
+            threads = max(1, atoi(argv[++i]));
+        else if (arg == "--order" && i + 1 < argc && parseNodeOrder(argv[i + 1], order))
+            i++;
+        else
+        {
+            cerr << "Usage: bench [--queries N] [--seed S] [--threads N] [--order hilbert|bfs|load]" << endl;
+            return 2;
+        }
+    }
+
+    // Progress goes to stderr; stdout carries only the CSV
+    streambuf *stdoutBuf = cout.rdbuf();
+    cout.rdbuf(cerr.rdbuf());
+    ostream out(stdoutBuf);
+    out << "kind,name,count,found,total_ms,qps,mean_ms,p50_ms,p95_ms,p99_ms,max_ms" << endl;
+
+    // Load phases always start from the CSVs, never the snapshot
+    const vector<string> sources = {"Dataset/Roadmap-Dhaka.csv", "Dataset/Routemap-DhakaMetroRail.csv",
+                                    "Dataset/Routemap-BikolpoBus.csv", "Dataset/Routemap-UttaraBus.csv"};
+    report(out, "load", "loadCsvSources/" + to_string(threads), {timeMs([&] { loadCsvSources(sources, threads); })}, 1);
+    // Per source: parse rows carry one time per parallel task, apply rows the serial graph insertion
+    for (const auto &timing : loadTimings)
+    {
+        string file = timing.file.substr(timing.file.find_last_of('/') + 1);
+        report(out, "load", "parse/" + file, timing.parse_ms, timing.rows);
+        report(out, "load", "apply/" + file, {timing.apply_ms}, timing.rows);
+    }
+    report(out, "load", "linkStationsToRoads", {timeMs([] { linkStationsToRoads(); })}, 1);
+    report(out, "load", "buildGraph", {timeMs([] { buildGraph(false); })}, 1); // renumberNodes derives the rest
+    report(out, "load", "renumberNodes/" + nodeOrderName(order), {timeMs([&] { renumberNodes(order); })}, 1);
+    report(out, "load", "buildSpatialIndex", {timeMs([] { buildSpatialIndex(); })}, 1);
+    if (nodes.empty())
+    {
+        cerr << "Error: no graph loaded." << endl;
+        return 1;
+    }
+
+    vector<BenchQuery> queries = makeWorkload(count, seed);
+    cerr << "Distance kernel: " << haversineIsa() << endl;
+    size_t interior = 0;
+    for (size_t v = 0; v < nodes.size(); v++)
+        interior += searchGraph.interior((int)v);
+    cerr << "Search graph: " << nodes.size() - interior << " of " << nodes.size() << " nodes, "
+         << searchGraph.targets.size() << " of " << graph.targets.size() << " arcs" << endl;
+    {
+        // Snap each query's start node position, offset ~300 m, back onto the graph
+        vector<double> ms;
+        size_t found = 0;
+        for (const auto &q : queries)
+            ms.push_back(timeMs([&] { found += getNearestNode(nodes[q.s].lat + 0.002, nodes[q.s].lon + 0.002) != -1; }));
+        report(out, "snap", "getNearestNode/" + haversineIsa(), ms, found);
+    }
+    runQueries<LazyHeap>(out, queries, "lazy");
+    runQueries<QuadHeap>(out, queries, "quad");
+    runQueries<RadixHeap>(out, queries, "radix");
+    return 0;
+}
@@ -0,0 +1,183 @@
+// Chains.cpp: Degree-2 Chain Compression
+// Roadmap rows are short street segments, so many nodes only join two segments of one road. The search
+// graph drops those interior nodes: a maximal run through them becomes one arc between the kept nodes at
+// its ends. A search relaxes such an arc part by part (same arithmetic as the full graph, so labels agree
+// to the last bit) and unpacks it into the original edges for the path. Queries that start or end inside
+// a chain add slices of it as extra arcs. Derived by finalizeGraph(), never stored in snapshots.
+#include <bits/stdc++.h>
+using namespace std;
+
+// Types without schedule waits, so a chain's time and cost are just the sum of its parts
+bool chainable(EdgeType t) { return t == ROAD || t == WALKING; }
+
+struct SearchGraph
+{
+    vector<int> offsets;    // node id -> first arc; interior nodes have none
+    vector<int> targets;    // arc -> head node
+    vector<int> links;      // arc -> graph edge id, or ~chain id for a compressed chain
+    vector<EdgeType> types; // arc -> type (one type per chain)
+
+    // Chains: directed runs from a kept node through interior nodes to a kept node
+    vector<int> chainStart; // chain id -> first slot in chainEdges; chain c is [chainStart[c], chainStart[c + 1])
+    vector<int> chainEdges; // graph edge ids in travel order
+
+    // Interior nodes lie on two chains, one per direction; pos is the number of chain edges before the node
+    vector<array<int, 2>> through; // node id -> chain ids, {-1, -1} for kept nodes
+    vector<array<int, 2>> pos;
+
+    bool interior(int v) const { return through[v][0] != -1; }
+    int chainLength(int c) const { return chainStart[c + 1] - chainStart[c]; }
+};
+SearchGraph searchGraph;
+
+// Edges [lo, hi) of a chain: a piece of it used as one arc by a single query
+struct ChainSlice
+{
+    int chain, lo, hi;
+    int tail() const { return graph.sources[searchGraph.chainEdges[searchGraph.chainStart[chain] + lo]]; }
+    int head() const { return graph.targets[searchGraph.chainEdges[searchGraph.chainStart[chain] + hi - 1]]; }
+    const int *edges() const { return &searchGraph.chainEdges[searchGraph.chainStart[chain] + lo]; }
+    int count() const { return hi - lo; }
+};
+
+// Graph edges behind search arc k, in travel order
+const int *arcEdges(int k, int &count)
+{
+    const SearchGraph &sg = searchGraph;
+    if (sg.links[k] >= 0)
+    {
+        count = 1;
+        return &sg.links[k];
+    }
+    int c = ~sg.links[k];
+    count = sg.chainLength(c);
+    return &sg.chainEdges[sg.chainStart[c]];
+}
+
+// Interior: unnamed, exactly one arc to and from each of two distinct neighbours, all of one chainable type
+vector<char> interiorNodes()
+{
+    size_t n = nodes.size();
+    vector<char> inner(n, 0);
+    for (size_t x = 0; x < n; x++)
+    {
+        int o = graph.offsets[x], i = graph.in_offsets[x];
+        if (!nodes[x].name.empty() || graph.offsets[x + 1] - o != 2 || graph.in_offsets[x + 1] - i != 2)
+            continue;
+        int p = graph.targets[o], q = graph.targets[o + 1];
+        int a = graph.sources[graph.in_edges[i]], b = graph.sources[graph.in_edges[i + 1]];
+        EdgeType t = graph.types[o];
+        if (p == q || p == (int)x || q == (int)x || !((a == p && b == q) || (a == q && b == p)) || !chainable(t) ||
+            graph.types[o + 1] != t || graph.types[graph.in_edges[i]] != t || graph.types[graph.in_edges[i + 1]] != t)
+            continue;
+        inner[x] = 1;
+    }
+    return inner;
+}
+
+// Walk from edge e through interior nodes to the next kept node; returns the edges taken
+void walkChain(int e, const vector<char> &inner, vector<int> &edges)
+{
+    edges.assign(1, e);
+    for (int prev = graph.sources[e], cur = graph.targets[e]; inner[cur];)
+    {
+        int o = graph.offsets[cur];
+        int next = graph.targets[o] != prev ? o : o + 1;
+        edges.push_back(next);
+        prev = cur;
+        cur = graph.targets[next];
+    }
+}
+
+void buildSearchGraph()
+{
+    size_t n = nodes.size();
+    SearchGraph sg;
+    vector<char> inner = interiorNodes();
+
+    // A cycle made only of interior nodes has no kept node to start from; keep its lowest id
+    vector<char> covered(n, 0);
+    vector<int> edges;
+    auto cover = [&](int u)
+    {
+        for (int e = graph.offsets[u]; e < graph.offsets[u + 1]; e++)
+            if (inner[graph.targets[e]])
+            {
+                walkChain(e, inner, edges);
+                for (size_t k = 0; k + 1 < edges.size(); k++)
+                    covered[graph.targets[edges[k]]] = 1;
+            }
+    };
+    for (size_t u = 0; u < n; u++)
+        if (!inner[u])
+            cover((int)u);
+    for (size_t x = 0; x < n; x++)
+        if (inner[x] && !covered[x])
+        {
+            inner[x] = 0;
+            cover((int)x);
+        }
+
+    // Arcs keep the order of the kept node's graph edges; a chain back to its own tail gets no arc
+    sg.offsets.assign(n + 1, 0);
+    sg.chainStart.push_back(0);
+    sg.through.assign(n, {-1, -1});
+    sg.pos.assign(n, {0, 0});
+    for (size_t u = 0; u < n; u++)
+    {
+        if (!inner[u])
+            for (int e = graph.offsets[u]; e < graph.offsets[u + 1]; e++)
+            {
+                int v = graph.targets[e];
+                if (!inner[v])
+                {
+                    sg.targets.push_back(v);
+                    sg.links.push_back(e);
+                    sg.types.push_back(graph.types[e]);
+                    continue;
+                }
+                int c = (int)sg.chainStart.size() - 1;
+                walkChain(e, inner, edges);
+                for (size_t k = 0; k + 1 < edges.size(); k++)
+                {
+                    int x = graph.targets[edges[k]], side = sg.through[x][0] == -1 ? 0 : 1;
+                    sg.through[x][side] = c;
+                    sg.pos[x][side] = (int)k + 1;
+                }
+                sg.chainEdges.insert(sg.chainEdges.end(), edges.begin(), edges.end());
+                sg.chainStart.push_back((int)sg.chainEdges.size());
+                int head = graph.targets[edges.back()];
+                if (head != (int)u)
+                {
+                    sg.targets.push_back(head);
+                    sg.links.push_back(~c);
+                    sg.types.push_back(graph.types[e]);
+                }
+            }
+        sg.offsets[u + 1] = (int)sg.targets.size();
+    }
+    searchGraph = move(sg);
+}
+
+// Extra arcs for one query: from an interior start toward both ends of its chains (or straight to an
+// interior end on the same chain), and into an interior end from both ends of its chains
+vector<ChainSlice> endpointSlices(int start, int end)
+{
+    const SearchGraph &sg = searchGraph;
+    vector<ChainSlice> slices;
+    for (int side = 0; side < 2; side++)
+    {
+        if (sg.interior(start))
+        {
+            int c = sg.through[start][side], p = sg.pos[start][side];
+            int stop = sg.chainLength(c);
+            for (int k = 0; end != -1 && k < 2; k++)
+                if (sg.interior(end) && sg.through[end][k] == c && sg.pos[end][k] > p)
+                    stop = sg.pos[end][k];
+            slices.push_back({c, p, stop});
+        }
+        if (end != -1 && sg.interior(end))
+            slices.push_back({sg.through[end][side], 0, sg.pos[end][side]});
+    }
+    return slices;
+}
@@ -0,0 +1,505 @@
+// ContractionHierarchy.cpp: Contraction Hierarchies for the static (distance / cost) queries
+// One hierarchy per Metric. Nodes are contracted in importance order; shortcuts keep distances intact,
+// and queries only climb towards more important nodes from both ends.
+#include <bits/stdc++.h>
+using namespace std;
+
+// An arc is either an original graph edge or a shortcut made of two arcs meeting at a contracted node
+struct CHArc
+{
+    int from, to;
+    double weight;
+    int edge_id;       // original edge, or -1 for a shortcut
+    int first, second; // shortcut halves (arc ids), -1 for original edges
+};
+
+struct ContractionHierarchy
+{
+    Metric metric;
+    vector<int> rank;   // node id -> contraction order
+    vector<CHArc> arcs; // original edges and shortcuts
+    // Upward search graph: up[u] = arcs u->x with rank[x] > rank[u];
+    // down[x] = arcs u->x with rank[u] > rank[x], scanned backwards from x
+    vector<int> up_offsets, up_arcs, down_offsets, down_arcs;
+    uint64_t traffic_version = 0; // overlay the weights were taken from (0 = base graph, classic contraction)
+};
+
+// Published hierarchies are immutable; a traffic update swaps in new ones, and queries holding the old
+// pointer finish on it undisturbed
+map<Metric, shared_ptr<const ContractionHierarchy>> chCache;
+mutex chMutex;
+
+// Contraction state: remaining graph, kept as per-node (neighbor, arc) lists
+struct CHBuilder
+{
+    const Metric &metric;
+    ContractionHierarchy &ch;
+    vector<vector<pair<int, int>>> out, in;
+    vector<char> contracted;
+    vector<int> deletedNeighbors;
+
+    // Witness search scratch, reset through the touched list
+    vector<double> dist;
+    vector<int> touched;
+
+    CHBuilder(const Metric &m, ContractionHierarchy &c) : metric(m), ch(c)
+    {
+        size_t n = nodes.size();
+        out.resize(n);
+        in.resize(n);
+        contracted.assign(n, 0);
+        deletedNeighbors.assign(n, 0);
+        dist.assign(n, INF);
+
+        // Keep the lightest of any parallel edges (lowest edge id on ties)
+        for (size_t e = 0; e < graph.targets.size(); e++)
+        {
+            if (!(metric.mask >> graph.types[e] & 1))
+                continue;
+            int u = graph.sources[e], v = graph.targets[e];
+            if (u != v)
+                addArc(u, v, graph.weights[e] * metric.factor[graph.types[e]], (int)e, -1, -1);
+        }
+    }
+
+    void addArc(int u, int v, double w, int edge_id, int first, int second)
+    {
+        for (auto &[x, a] : out[u])
+            if (x == v)
+            {
+                if (ch.arcs[a].weight <= w)
+                    return;
+                ch.arcs[a].weight = INF; // superseded; left out of the search graph
+                int id = (int)ch.arcs.size();
+                ch.arcs.push_back({u, v, w, edge_id, first, second});
+                a = id;
+                for (auto &[y, b] : in[v])
+                    if (y == u)
+                        b = id;
+                return;
+            }
+        int id = (int)ch.arcs.size();
+        ch.arcs.push_back({u, v, w, edge_id, first, second});
+        out[u].push_back({v, id});
+        in[v].push_back({u, id});
+    }
+
+    // Bounded Dijkstra from src in the remaining graph, never passing through `skip`
+    void witnessSearch(int src, int skip, double limit, int maxSettled)
+    {
+        for (int v : touched)
+            dist[v] = INF;
+        touched.clear();
+
+        priority_queue<pair<double, int>, vector<pair<double, int>>, greater<pair<double, int>>> pq;
+        dist[src] = 0;
+        touched.push_back(src);
+        pq.push({0, src});
+        int settled = 0;
+        while (!pq.empty() && settled < maxSettled)
+        {
+            auto [d, u] = pq.top();
+            pq.pop();
+            if (d > dist[u])
+                continue;
+            if (d > limit)
+                break;
+            settled++;
+            for (auto [x, a] : out[u])
+            {
+                if (x == skip || contracted[x])
+                    continue;
+                double nd = d + ch.arcs[a].weight;
+                if (nd < dist[x])
+                {
+                    if (dist[x] == INF)
+                        touched.push_back(x);
+                    dist[x] = nd;
+                    pq.push({nd, x});
+                }
+            }
+        }
+    }
+
+    // Shortcuts needed to contract v; when apply is set they are inserted
+    int contract(int v, bool apply)
+    {
+        int added = 0;
+        for (auto [u, a1] : in[v])
+        {
+            if (contracted[u])
+                continue;
+            double limit = -1;
+            for (auto [x, a2] : out[v])
+                if (!contracted[x] && x != u)
+                    limit = max(limit, ch.arcs[a1].weight + ch.arcs[a2].weight);
+            if (limit < 0)
+                continue;
+
+            witnessSearch(u, v, limit, apply ? 1000 : 200);
+            for (auto [x, a2] : out[v])
+            {
+                if (contracted[x] || x == u)
+                    continue;
+                double w = ch.arcs[a1].weight + ch.arcs[a2].weight;
+                if (dist[x] <= w)
+                    continue;
+                added++;
+                if (apply)
+                    addArc(u, x, w, -1, a1, a2);
+            }
+        }
+        return added;
+    }
+
+    int priority(int v)
+    {
+        int degree = 0;
+        for (auto [u, a] : in[v])
+            degree += !contracted[u];
+        for (auto [x, a] : out[v])
+            degree += !contracted[x];
+        return 2 * contract(v, false) - degree + deletedNeighbors[v];
+    }
+
+    void run()
+    {
+        size_t n = nodes.size();
+        ch.rank.assign(n, -1);
+        priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;
+        for (size_t v = 0; v < n; v++)
+            pq.push({priority((int)v), (int)v});
+
+        int order = 0;
+        while (!pq.empty())
+        {
+            auto [p, v] = pq.top();
+            pq.pop();
+            if (contracted[v])
+                continue;
+
+            // Lazy update: re-evaluate and postpone if no longer the cheapest
+            int fresh = priority(v);
+            if (!pq.empty() && fresh > pq.top().first)
+            {
+                pq.push({fresh, v});
+                continue;
+            }
+
+            contract(v, true);
+            contracted[v] = 1;
+            ch.rank[v] = order++;
+
+            set<int> neighbors;
+            for (auto [u, a] : in[v])
+                if (!contracted[u])
+                    neighbors.insert(u);
+            for (auto [x, a] : out[v])
+                if (!contracted[x])
+                    neighbors.insert(x);
+            for (int u : neighbors)
+            {
+                deletedNeighbors[u]++;
+                pq.push({priority(u), u});
+            }
+        }
+    }
+};
+
+void buildSearchGraph(ContractionHierarchy &ch)
+{
+    size_t n = nodes.size();
+    ch.up_offsets.assign(n + 1, 0);
+    ch.down_offsets.assign(n + 1, 0);
+    for (const auto &a : ch.arcs)
+    {
+        if (a.weight == INF)
+            continue;
+        if (ch.rank[a.to] > ch.rank[a.from])
+            ch.up_offsets[a.from + 1]++;
+        else
+            ch.down_offsets[a.to + 1]++;
+    }
+    for (size_t v = 0; v < n; v++)
+    {
+        ch.up_offsets[v + 1] += ch.up_offsets[v];
+        ch.down_offsets[v + 1] += ch.down_offsets[v];
+    }
+    ch.up_arcs.resize(ch.up_offsets[n]);
+    ch.down_arcs.resize(ch.down_offsets[n]);
+    vector<int> upFill(ch.up_offsets.begin(), ch.up_offsets.end() - 1);
+    vector<int> downFill(ch.down_offsets.begin(), ch.down_offsets.end() - 1);
+    for (size_t i = 0; i < ch.arcs.size(); i++)
+    {
+        const CHArc &a = ch.arcs[i];
+        if (a.weight == INF)
+            continue;
+        if (ch.rank[a.to] > ch.rank[a.from])
+            ch.up_arcs[upFill[a.from]++] = (int)i;
+        else
+            ch.down_arcs[downFill[a.to]++] = (int)i;
+    }
+}
+
+// Section: Customizable hierarchy
+// Traffic changes weights but not topology, so once an overlay is active hierarchies come from a
+// metric-independent order (min-degree over every edge, with its fill-in) and only the arc weights are
+// recomputed. Customization is one bottom-up pass over the lower triangles of each arc.
+struct CCHTopology
+{
+    vector<int> rank;
+    vector<pair<int, int>> arcs;     // (low, high) by rank; every node's upward arcs are contiguous
+    vector<int> first_arc;           // node -> first arc with that node as low end
+    vector<array<int, 3>> triangles; // (low-mid, low-high, mid-high) in increasing rank of low
+};
+
+CCHTopology cchTopo;
+bool cchBuilt = false; // guarded by chMutex, like the cache
+
+const CCHTopology &cchTopology()
+{
+    CCHTopology &topo = cchTopo;
+    if (cchBuilt)
+        return topo;
+    size_t n = nodes.size();
+    vector<set<int>> adj(n);
+    for (size_t e = 0; e < graph.targets.size(); e++)
+        if (graph.sources[e] != graph.targets[e])
+        {
+            adj[graph.sources[e]].insert(graph.targets[e]);
+            adj[graph.targets[e]].insert(graph.sources[e]);
+        }
+
+    // Eliminate the lowest-degree node, turning its remaining neighbours into a clique (lazy queue)
+    vector<vector<int>> upper(n);
+    topo.rank.assign(n, -1);
+    priority_queue<pair<size_t, int>, vector<pair<size_t, int>>, greater<pair<size_t, int>>> pq;
+    for (size_t v = 0; v < n; v++)
+        pq.push({adj[v].size(), (int)v});
+    int order = 0;
+    while (!pq.empty())
+    {
+        auto [d, v] = pq.top();
+        pq.pop();
+        if (topo.rank[v] != -1 || d != adj[v].size())
+            continue;
+        topo.rank[v] = order++;
+        upper[v].assign(adj[v].begin(), adj[v].end());
+        for (int x : upper[v])
+        {
+            adj[x].erase(v);
+            for (int y : upper[v])
+                if (y != x)
+                    adj[x].insert(y);
+        }
+        for (int x : upper[v])
+            pq.push({adj[x].size(), x});
+        set<int>().swap(adj[v]);
+    }
+
+    vector<int> byRank(n);
+    for (size_t v = 0; v < n; v++)
+        byRank[topo.rank[v]] = (int)v;
+    topo.first_arc.assign(n + 1, 0);
+    for (size_t v = 0; v < n; v++)
+        topo.first_arc[v + 1] = topo.first_arc[v] + (int)upper[v].size();
+    topo.arcs.resize(topo.first_arc[n]);
+    for (size_t v = 0; v < n; v++)
+    {
+        sort(upper[v].begin(), upper[v].end(), [&](int a, int b) { return topo.rank[a] < topo.rank[b]; });
+        for (size_t k = 0; k < upper[v].size(); k++)
+            topo.arcs[topo.first_arc[v] + k] = {(int)v, upper[v][k]};
+    }
+
+    // Upward arc (x, y) by binary search on rank in x's contiguous block
+    auto arcOf = [&](int x, int y)
+    {
+        auto begin = topo.arcs.begin() + topo.first_arc[x], end = topo.arcs.begin() + topo.first_arc[x + 1];
+        return (int)(lower_bound(begin, end, y, [&](const pair<int, int> &a, int t)
+                                 { return topo.rank[a.second] < topo.rank[t]; }) -
+                     topo.arcs.begin());
+    };
+    for (int r = 0; r < (int)n; r++)
+    {
+        int z = byRank[r];
+        for (int i = topo.first_arc[z]; i < topo.first_arc[z + 1]; i++)
+            for (int j = i + 1; j < topo.first_arc[z + 1]; j++)
+                topo.triangles.push_back({i, j, arcOf(topo.arcs[i].second, topo.arcs[j].second)});
+    }
+    cchBuilt = true;
+    return topo;
+}
+
+// Weights for one metric under one overlay; arc 2a runs low -> high, arc 2a+1 high -> low
+shared_ptr<const ContractionHierarchy> customizeHierarchy(const Metric &metric, const TrafficOverlay &traffic)
+{
+    const CCHTopology &topo = cchTopology();
+    auto ch = make_shared<ContractionHierarchy>();
+    ch->metric = metric;
+    ch->rank = topo.rank;
+    ch->traffic_version = traffic.version;
+    ch->arcs.resize(2 * topo.arcs.size());
+    for (size_t a = 0; a < topo.arcs.size(); a++)
+    {
+        auto [low, high] = topo.arcs[a];
+        ch->arcs[2 * a] = {low, high, INF, -1, -1, -1};
+        ch->arcs[2 * a + 1] = {high, low, INF, -1, -1, -1};
+    }
+
+    // Original edges seed their arc (lightest parallel edge wins, lowest id on ties)
+    const vector<double> &weights = traffic.routingWeights();
+    for (size_t e = 0; e < graph.targets.size(); e++)
+    {
+        int u = graph.sources[e], v = graph.targets[e];
+        if (u == v || !(metric.mask >> graph.types[e] & 1) || weights[e] == INF)
+            continue;
+        int low = topo.rank[u] < topo.rank[v] ? u : v, high = low == u ? v : u;
+        int a = topo.first_arc[low];
+        while (topo.arcs[a].second != high)
+            a++;
+        CHArc &arc = ch->arcs[2 * a + (u == low ? 0 : 1)];
+        double w = weights[e] * metric.factor[graph.types[e]];
+        if (w < arc.weight)
+            arc.weight = w, arc.edge_id = (int)e;
+    }
+
+    // Lower triangles z < x < y: x -> z -> y and y -> z -> x may undercut the arc between x and y
+    for (const auto &[a1, a2, a3] : topo.triangles)
+    {
+        CHArc &up = ch->arcs[2 * a3], &down = ch->arcs[2 * a3 + 1];
+        double w = ch->arcs[2 * a1 + 1].weight + ch->arcs[2 * a2].weight;
+        if (w < up.weight)
+            up = {up.from, up.to, w, -1, 2 * a1 + 1, 2 * a2};
+        w = ch->arcs[2 * a2 + 1].weight + ch->arcs[2 * a1].weight;
+        if (w < down.weight)
+            down = {down.from, down.to, w, -1, 2 * a2 + 1, 2 * a1};
+    }
+    buildSearchGraph(*ch);
+    return ch;
+}
+
+// Hierarchies, the customizable topology, ALT landmarks and the transit network all hold node ids of
+// the graph they were built on; finalizeGraph() drops them whenever the graph is rebuilt, renumbered
+// or reloaded
+void clearGraphCaches()
+{
+    clearTransitNetwork();
+    {
+        lock_guard<mutex> lock(chMutex);
+        chCache.clear();
+        cchTopo = CCHTopology();
+        cchBuilt = false;
+    }
+    lock_guard<mutex> lock(landmarkMutex);
+    landmarkCache.clear();
+}
+
+// Build (or fetch) the hierarchy for a metric; safe to call from several threads
+shared_ptr<const ContractionHierarchy> buildContractionHierarchy(const Metric &metric)
+{
+    lock_guard<mutex> lock(chMutex);
+    auto traffic = currentTraffic();
+    auto &slot = chCache[metric];
+    if (slot && slot->traffic_version == traffic->version)
+        return slot;
+
+    if (traffic->version == 0)
+    {
+        auto ch = make_shared<ContractionHierarchy>();
+        ch->metric = metric;
+        CHBuilder(metric, *ch).run();
+        buildSearchGraph(*ch);
+        slot = ch;
+    }
+    else
+        slot = customizeHierarchy(metric, *traffic);
+    return slot;
+}
+
+shared_ptr<const ContractionHierarchy> buildContractionHierarchy(bool opt_cost, map<EdgeType, double> rates, vector<EdgeType> modes)
+{
+    return buildContractionHierarchy(makeMetric(opt_cost, rates, modes));
+}
+
+// Expand an arc into the original edge ids it stands for, in travel order
+void unpackArc(const ContractionHierarchy &ch, int arc, vector<int> &edges)
+{
+    const CHArc &a = ch.arcs[arc];
+    if (a.edge_id >= 0)
+    {
+        edges.push_back(a.edge_id);
+        return;
+    }
+    unpackArc(ch, a.first, edges);
+    unpackArc(ch, a.second, edges);
+}
+
+// Bidirectional upward query; same SolutionPath contract as dijkstra_standard
+SolutionPath chQuery(const ContractionHierarchy &ch, int start, int end, map<EdgeType, double> rates)
+{
+    SearchWorkspace *ws[2] = {&threadWorkspace(0), &threadWorkspace(1)}; // parent_edge holds arc ids here
+    thread_local StaticQueue pq[2];
+    pq[0].clear();
+    pq[1].clear();
+    ws[0]->begin();
+    ws[1]->begin();
+    ws[0]->set(start, 0, -1);
+    ws[1]->set(end, 0, -1);
+    pq[0].push(0, start);
+    pq[1].push(0, end);
+
+    double best = INF;
+    int meet = -1;
+    if (start == end)
+        best = 0, meet = start;
+
+    while (!pq[0].empty() || !pq[1].empty())
+    {
+        // Each side can stop once its queue minimum reaches the best meeting distance
+        for (int side = 0; side < 2; side++)
+            if (!pq[side].empty() && pq[side].minKey() >= best)
+                pq[side].clear();
+        int side = pq[0].empty() ? 1 : pq[1].empty() ? 0 : (pq[0].minKey() <= pq[1].minKey() ? 0 : 1);
+        if (pq[side].empty())
+            break;
+
+        SearchWorkspace &self = *ws[side], &other = *ws[1 - side];
+        auto [d, u] = pq[side].pop();
+        if (d > self.dist[u])
+            continue;
+        if (other.distOf(u) < INF && d + other.distOf(u) < best)
+        {
+            best = d + other.distOf(u);
+            meet = u;
+        }
+
+        const vector<int> &offsets = side == 0 ? ch.up_offsets : ch.down_offsets;
+        const vector<int> &list = side == 0 ? ch.up_arcs : ch.down_arcs;
+        for (int k = offsets[u]; k < offsets[u + 1]; k++)
+        {
+            const CHArc &a = ch.arcs[list[k]];
+            int v = side == 0 ? a.to : a.from;
+            double nd = d + a.weight;
+            if (nd < self.distOf(v))
+            {
+                self.set(v, nd, list[k]);
+                pq[side].push(nd, v);
+            }
+        }
+    }
+
+    if (meet == -1)
+        return SolutionPath();
+
+    thread_local vector<int> upArcs, edgeIds;
+    upArcs.clear();
+    edgeIds.clear();
+    for (int v = meet; v != start; v = ch.arcs[ws[0]->parent_edge[v]].from)
+        upArcs.push_back(ws[0]->parent_edge[v]);
+    reverse(upArcs.begin(), upArcs.end());
+    for (int v = meet; v != end; v = ch.arcs[ws[1]->parent_edge[v]].to)
+        upArcs.push_back(ws[1]->parent_edge[v]);
+    for (int a : upArcs)
+        unpackArc(ch, a, edgeIds);
+    return pathFromEdges(start, edgeIds, typeTable(rates));
+}
@@ -1,147 +1,695 @@
 // DataLoader.cpp: CSV Parsing
 #include <bits/stdc++.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "Models.cpp"
+#include "Chains.cpp"
 using namespace std;
 
-// Add Edge to Adjacency List (Bi-directional)
-void addEdge(int u, int v, double dist, EdgeType type, vector<Point> geom)
+// Add Edge to Adjacency List (Bi-directional); both directions share one pooled polyline
+void addEdge(int u, int v, double dist, EdgeType type, const Point *geom, size_t n)
 {
-    Edge e1 = {v, dist, type, geom};
-    adj[u].push_back(e1);
+    GeomRef ref = storePolyline(geom, n);
+    adj[u].push_back({v, dist, type, ref});
+    adj[v].push_back({u, dist, type, ref.flipped()});
+}
+void addEdge(int u, int v, double dist, EdgeType type, const vector<Point> &geom)
+{
+    addEdge(u, v, dist, type, geom.data(), geom.size());
+}
+
+// Memory-mapped CSV reader: rows are handed out as string_views into the mapping
+struct MappedFile
+{
+    const char *data = nullptr;
+    size_t size = 0;
 
-    reverse(geom.begin(), geom.end());
-    Edge e2 = {u, dist, type, geom};
-    adj[v].push_back(e2);
+    MappedFile(const string &filename)
+    {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED)
+            {
+                data = (const char *)p;
+                size = st.st_size;
+                madvise(p, size, MADV_SEQUENTIAL);
+            }
+        }
+        close(fd);
+    }
+    ~MappedFile()
+    {
+        if (data)
+            munmap((void *)data, size);
+    }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+};
+
+// Split [begin, end) on ',' the way getline(ss, token, ',') does: a trailing empty field is dropped
+void splitRow(const char *begin, const char *end, vector<string_view> &parts)
+{
+    parts.clear();
+    const char *p = begin;
+    while (p < end)
+    {
+        const char *comma = (const char *)memchr(p, ',', end - p);
+        const char *stop = comma ? comma : end;
+        parts.emplace_back(p, stop - p);
+        p = comma ? comma + 1 : end;
+    }
 }
 
-// Parse Roadmap-Dhaka.csv
-void parseRoadMap(const string &filename)
+// Executor: run fn(i) for i in [0, count) on `threads` workers pulling indices from a shared counter
+template <typename Fn>
+void parallelFor(size_t count, int threads, Fn fn)
 {
-    ifstream file(filename);
-    string line;
-    while (getline(file, line))
+    threads = max(1, min<int>(threads, (int)count));
+    atomic<size_t> next(0);
+    auto worker = [&]()
     {
-        if (line.rfind("DhakaStreet", 0) != 0)
-            continue;
+        for (size_t i; (i = next++) < count;)
+            fn(i);
+    };
+    vector<thread> pool;
+    for (int t = 1; t < threads; t++)
+        pool.emplace_back(worker);
+    worker();
+    for (auto &t : pool)
+        t.join();
+}
 
-        stringstream ss(line);
-        string token;
-        vector<string> parts;
-        while (getline(ss, token, ','))
-            parts.push_back(token);
+int defaultThreadCount() { return max(1u, thread::hardware_concurrency()); }
 
-        if (parts.size() < 6)
-            continue;
+// Rows of [begin, end); the range must start at a row boundary
+template <typename RowHandler>
+void forEachCsvRow(const char *begin, const char *end, RowHandler handle)
+{
+    vector<string_view> parts; // reused across rows
+    const char *p = begin;
+    while (p < end)
+    {
+        const char *nl = (const char *)memchr(p, '\n', end - p);
+        const char *eol = nl ? nl : end;
+        splitRow(p, eol, parts);
+        handle(string_view(p, eol - p), parts);
+        p = nl ? nl + 1 : end;
+    }
+}
 
-        double dist = stod(parts.back());
-        vector<Point> polyline;
-        for (size_t i = 1; i < parts.size() - 2; i += 2)
-        {
-            polyline.push_back({stod(parts[i + 1]), stod(parts[i])}); // Lat, Lon
-        }
+template <typename RowHandler>
+void forEachCsvRow(const string &filename, RowHandler handle)
+{
+    MappedFile file(filename);
+    forEachCsvRow(file.data, file.data + file.size, handle);
+}
 
-        if (polyline.size() < 2)
-            continue;
+// Split a mapped file into about `count` byte ranges, each moved forward to start a row
+vector<pair<const char *, const char *>> splitCsvChunks(const MappedFile &file, int count)
+{
+    vector<pair<const char *, const char *>> chunks;
+    const char *begin = file.data, *end = file.data + file.size;
+    for (int k = 0; k < count && begin < end; k++)
+    {
+        const char *stop = k == count - 1 ? end : file.data + file.size * (k + 1) / count;
+        if (stop < begin)
+            stop = begin;
+        const char *nl = stop < end ? (const char *)memchr(stop, '\n', end - stop) : nullptr;
+        stop = nl ? nl + 1 : end;
+        chunks.push_back({begin, stop});
+        begin = stop;
+    }
+    return chunks;
+}
 
-        int u = getOrCreateNodeID(polyline[0].lat, polyline[0].lon);
-        int v = getOrCreateNodeID(polyline.back().lat, polyline.back().lon);
-        addEdge(u, v, dist, ROAD, polyline);
+// Same acceptance as stod: leading whitespace and trailing garbage are ignored
+double parseDouble(string_view s)
+{
+    const char *p = s.data(), *end = s.data() + s.size();
+    while (p < end && isspace((unsigned char)*p))
+        p++;
+    if (p < end && *p == '+')
+        p++;
+    double value = 0;
+    if (from_chars(p, end, value).ec != errc())
+        throw invalid_argument("parseDouble: " + string(s));
+    return value;
+}
+
+// Rows are parsed independently (safe on any thread) and applied to the graph in file order.
+// A chunk's polylines share one point buffer; rows address their run of it.
+struct ParsedEdge
+{
+    EdgeType type;
+    double dist;
+    uint32_t first, count;          // polyline: points[first, first + count) of the chunk
+    string_view startName, endName; // route stations; views into the mapped file
+};
+
+struct ParsedChunk
+{
+    vector<Point> points;
+    vector<ParsedEdge> rows;
+};
+
+// Coordinates are lon,lat pairs between the type column and the last two columns; appended to points
+void parsePolyline(const vector<string_view> &parts, vector<Point> &points, ParsedEdge &out)
+{
+    out.first = (uint32_t)points.size();
+    for (size_t i = 1; i < parts.size() - 2; i += 2)
+        points.push_back({parseDouble(parts[i + 1]), parseDouble(parts[i])}); // Lat, Lon
+    out.count = (uint32_t)(points.size() - out.first);
+}
+
+// Roadmap-Dhaka.csv row; a rejected row leaves points as it was
+bool parseRoadRow(string_view line, const vector<string_view> &parts, vector<Point> &points, ParsedEdge &out)
+{
+    if (line.rfind("DhakaStreet", 0) != 0 || parts.size() < 6)
+        return false;
+    out.type = ROAD;
+    out.dist = parseDouble(parts.back());
+    parsePolyline(parts, points, out);
+    if (out.count >= 2)
+        return true;
+    points.resize(out.first);
+    return false;
+}
+
+// Transport CSV row
+bool parseRouteRow(EdgeType type, const vector<string_view> &parts, vector<Point> &points, ParsedEdge &out)
+{
+    if (parts.size() < 3)
+        return false;
+
+    string_view tType = parts[0];
+    if (type == METRO && tType != "DhakaMetroRail")
+        return false;
+    if ((type == BUS_BIKOLPO || type == BUS_UTTARA) && tType.find("DhakaBus") == string_view::npos)
+        return false;
+
+    out.type = type;
+    out.startName = parts[parts.size() - 2];
+    out.endName = parts[parts.size() - 1];
+    parsePolyline(parts, points, out);
+    if (out.count == 0)
+        return false;
+    out.dist = polylineDistance(&points[out.first], out.count);
+    return true;
+}
+
+// Node creation, naming and edge insertion; serial, so ids depend only on row order
+void applyParsedEdge(const ParsedEdge &row, const vector<Point> &points)
+{
+    const Point *line = &points[row.first];
+    int u = getOrCreateNodeID(line[0].lat, line[0].lon);
+    int v = getOrCreateNodeID(line[row.count - 1].lat, line[row.count - 1].lon);
+    if (row.type != ROAD)
+    {
+        // Create/Find Nodes for Stations
+        if (nodes[u].name.empty())
+            nodes[u].name = internName(row.startName);
+        if (nodes[v].name.empty())
+        {
+            // Clean Names
+            thread_local string clean;
+            clean.assign(row.endName);
+            clean.erase(remove(clean.begin(), clean.end(), '\r'), clean.end());
+            nodes[v].name = internName(clean);
+        }
     }
+    addEdge(u, v, row.dist, row.type, line, row.count);
+}
+
+// Parse Roadmap-Dhaka.csv
+void parseRoadMap(const string &filename)
+{
+    ParsedEdge row;
+    vector<Point> points;
+    forEachCsvRow(filename, [&](string_view line, const vector<string_view> &parts)
+    {
+        points.clear();
+        if (parseRoadRow(line, parts, points, row))
+            applyParsedEdge(row, points);
+    });
     cout << "Loaded Roadmap. Nodes: " << nodes.size() << ", Edges: " << adj.size() << endl;
 }
 
 // Parse Transport CSVs
 void parseRouteMap(const string &filename, EdgeType type)
 {
-    ifstream file(filename);
-    string line;
-    while (getline(file, line))
+    ParsedEdge row;
+    vector<Point> points;
+    forEachCsvRow(filename, [&](string_view, const vector<string_view> &parts)
     {
-        stringstream ss(line);
-        string token;
-        vector<string> parts;
-        while (getline(ss, token, ','))
-            parts.push_back(token);
+        points.clear();
+        if (parseRouteRow(type, parts, points, row))
+            applyParsedEdge(row, points);
+    });
+}
 
-        if (parts.empty())
-            continue;
+// Per-source phase timings of the last loadCsvSources call, in sources order (read by the benchmark)
+struct SourceLoadTiming
+{
+    string file;
+    vector<double> parse_ms; // one per task: the roadmap is parsed as several chunks
+    double apply_ms = 0;
+    size_t rows = 0;         // rows applied to the graph
+};
+vector<SourceLoadTiming> loadTimings;
 
-        string tType = parts[0];
-        if (type == METRO && tType != "DhakaMetroRail")
-            continue;
-        if ((type == BUS_BIKOLPO || type == BUS_UTTARA) && tType.find("DhakaBus") == string::npos)
-            continue;
+// Parallel Loading: the roadmap is cut into byte-range chunks and the route files are whole tasks;
+// all are parsed concurrently, then applied serially in file and row order. The graph is therefore
+// the same as parseRoadMap + parseRouteMap would build, for any thread count.
+// sources: roadmap, metro, Bikolpo bus, Uttara bus
+void loadCsvSources(const vector<string> &sources, int threads)
+{
+    const EdgeType types[] = {ROAD, METRO, BUS_BIKOLPO, BUS_UTTARA};
+    vector<unique_ptr<MappedFile>> files;
+    for (const auto &f : sources)
+        files.push_back(make_unique<MappedFile>(f));
+    auto elapsedMs = [](chrono::steady_clock::time_point t0)
+    { return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count(); };
+
+    struct Task
+    {
+        EdgeType type;
+        const char *begin, *end;
+        size_t source; // index into sources
+    };
+    vector<Task> tasks;
+    // A few chunks per thread evens out rows of different lengths
+    for (auto [b, e] : splitCsvChunks(*files[0], max(1, threads) * 4))
+        tasks.push_back({ROAD, b, e, 0});
+    size_t roadTasks = tasks.size();
+    for (size_t f = 1; f < files.size() && f < 4; f++)
+        tasks.push_back({types[f], files[f]->data, files[f]->data + files[f]->size, f});
 
-        string startName = parts[parts.size() - 2];
-        string endName = parts[parts.size() - 1];
+    vector<ParsedChunk> parsed(tasks.size());
+    vector<double> parseMs(tasks.size());
+    parallelFor(tasks.size(), threads, [&](size_t t)
+                {
+                    auto t0 = chrono::steady_clock::now();
+                    const Task &task = tasks[t];
+                    ParsedChunk &chunk = parsed[t];
+                    // Rows run ~100 bytes with ~6 points each; one reservation covers most chunks
+                    size_t bytes = task.end - task.begin;
+                    chunk.rows.reserve(bytes / 64);
+                    chunk.points.reserve(bytes / 16);
+                    ParsedEdge row;
+                    forEachCsvRow(task.begin, task.end, [&](string_view line, const vector<string_view> &parts)
+                                  {
+                                      bool ok = task.type == ROAD ? parseRoadRow(line, parts, chunk.points, row)
+                                                                  : parseRouteRow(task.type, parts, chunk.points, row);
+                                      if (ok)
+                                          chunk.rows.push_back(row);
+                                  });
+                    parseMs[t] = elapsedMs(t0);
+                });
 
-        // Clean Names
-        endName.erase(remove(endName.begin(), endName.end(), '\r'), endName.end());
-        endName.erase(remove(endName.begin(), endName.end(), '\n'), endName.end());
+    // Size the graph-lifetime containers once: every row adds at most two nodes and its polyline
+    size_t rows = 0, points = 0;
+    for (const auto &chunk : parsed)
+        rows += chunk.rows.size(), points += chunk.points.size();
+    nodes.reserve(nodes.size() + 2 * rows);
+    dedupNext.reserve(nodes.capacity());
+    dedupHead.reserve(dedupHead.size() + 2 * rows);
+    geometryPool.reserve(geometryPool.size() + points);
 
-        vector<Point> polyline;
-        for (size_t i = 1; i < parts.size() - 2; i += 2)
+    loadTimings.assign(sources.size(), SourceLoadTiming());
+    for (size_t f = 0; f < sources.size(); f++)
+        loadTimings[f].file = sources[f];
+    auto apply = [&](size_t from, size_t to)
+    {
+        for (size_t t = from; t < to; t++)
         {
-            polyline.push_back({stod(parts[i + 1]), stod(parts[i])});
+            auto t0 = chrono::steady_clock::now();
+            for (const auto &row : parsed[t].rows)
+                applyParsedEdge(row, parsed[t].points);
+            SourceLoadTiming &timing = loadTimings[tasks[t].source];
+            timing.parse_ms.push_back(parseMs[t]);
+            timing.apply_ms += elapsedMs(t0);
+            timing.rows += parsed[t].rows.size();
+            parsed[t] = ParsedChunk();
         }
+    };
+    apply(0, roadTasks);
+    cout << "Loaded Roadmap. Nodes: " << nodes.size() << ", Edges: " << adj.size() << endl;
+    apply(roadTasks, tasks.size());
+}
 
-        if (polyline.empty())
-            continue;
+// Segment R-tree: static, STR-packed tree over the straight pieces of every road polyline.
+// Coordinates are planar km around a reference latitude, which is exact enough at city scale.
+struct RoadSegment
+{
+    int u, slot, piece; // edge adj[u][slot], polyline piece [piece, piece + 1]
+    double x0, y0, x1, y1;
+};
 
-        // Create/Find Nodes for Stations
-        int u = -1, v = -1;
-        // Simple search for existing named node or create new
-        u = getOrCreateNodeID(polyline[0].lat, polyline[0].lon);
-        if (nodes[u].name.empty())
-            nodes[u].name = startName;
+struct SegmentTree
+{
+    struct Box
+    {
+        double minX, minY, maxX, maxY;
+        int first, count; // children (or segments, on the leaf level)
+    };
+    static const int FANOUT = 16;
+    double cosRef = 1;
+    vector<RoadSegment> segments; // leaf order
+    vector<vector<Box>> levels;   // levels[0] = leaves, back() = root level
 
-        v = getOrCreateNodeID(polyline.back().lat, polyline.back().lon);
-        if (nodes[v].name.empty())
-            nodes[v].name = endName;
+    double kmX(double lon) const { return toRadians(lon) * 6371 * cosRef; }
+    double kmY(double lat) const { return toRadians(lat) * 6371; }
 
-        // Calc Distance
-        double dist = 0;
-        for (size_t i = 0; i < polyline.size() - 1; i++)
+    static double boxDist(const Box &b, double x, double y)
+    {
+        double dx = max({b.minX - x, 0.0, x - b.maxX}), dy = max({b.minY - y, 0.0, y - b.maxY});
+        return sqrt(dx * dx + dy * dy);
+    }
+
+    // Sort-tile-recursive packing: slices by x, then runs by y within each slice
+    void build(vector<RoadSegment> segs)
+    {
+        segments = move(segs);
+        levels.clear();
+        if (segments.empty())
+            return;
+        auto cx = [](const RoadSegment &s) { return s.x0 + s.x1; };
+        auto cy = [](const RoadSegment &s) { return s.y0 + s.y1; };
+        size_t leaves = (segments.size() + FANOUT - 1) / FANOUT;
+        size_t slice = (size_t)ceil(sqrt((double)leaves)) * FANOUT;
+        sort(segments.begin(), segments.end(), [&](const RoadSegment &a, const RoadSegment &b) { return cx(a) < cx(b); });
+        for (size_t i = 0; i < segments.size(); i += slice)
+            sort(segments.begin() + i, segments.begin() + min(i + slice, segments.size()),
+                 [&](const RoadSegment &a, const RoadSegment &b) { return cy(a) < cy(b); });
+
+        levels.emplace_back();
+        for (size_t i = 0; i < segments.size(); i += FANOUT)
         {
-            dist += getDistance(polyline[i].lat, polyline[i].lon, polyline[i + 1].lat, polyline[i + 1].lon);
+            Box b{INF, INF, -INF, -INF, (int)i, (int)min<size_t>(FANOUT, segments.size() - i)};
+            for (int k = 0; k < b.count; k++)
+            {
+                const RoadSegment &s = segments[i + k];
+                b.minX = min({b.minX, s.x0, s.x1});
+                b.minY = min({b.minY, s.y0, s.y1});
+                b.maxX = max({b.maxX, s.x0, s.x1});
+                b.maxY = max({b.maxY, s.y0, s.y1});
+            }
+            levels.back().push_back(b);
         }
+        // Leaves are already spatially ordered, so upper levels just group consecutive boxes
+        while (levels.back().size() > 1)
+        {
+            const vector<Box> &below = levels.back();
+            vector<Box> above;
+            for (size_t i = 0; i < below.size(); i += FANOUT)
+            {
+                Box b{INF, INF, -INF, -INF, (int)i, (int)min<size_t>(FANOUT, below.size() - i)};
+                for (int k = 0; k < b.count; k++)
+                {
+                    const Box &c = below[i + k];
+                    b.minX = min(b.minX, c.minX);
+                    b.minY = min(b.minY, c.minY);
+                    b.maxX = max(b.maxX, c.maxX);
+                    b.maxY = max(b.maxY, c.maxY);
+                }
+                above.push_back(b);
+            }
+            levels.push_back(move(above));
+        }
+    }
 
-        addEdge(u, v, dist, type, polyline);
+    // Best-first nearest segment to (x, y) among those accepted by `allow`; returns the segment index or -1
+    // and sets t to the projection parameter along it
+    template <typename Allow>
+    int nearest(double x, double y, double maxDist, Allow allow, double &t) const
+    {
+        if (levels.empty())
+            return -1;
+        typedef tuple<double, int, int> Item; // distance, level (-1 = segment), index
+        priority_queue<Item, vector<Item>, greater<Item>> pq;
+        int top = (int)levels.size() - 1;
+        for (size_t i = 0; i < levels[top].size(); i++)
+            pq.push({boxDist(levels[top][i], x, y), top, (int)i});
+        while (!pq.empty())
+        {
+            auto [d, level, i] = pq.top();
+            pq.pop();
+            if (d > maxDist)
+                return -1;
+            if (level == -1)
+            {
+                const RoadSegment &s = segments[i];
+                double dx = s.x1 - s.x0, dy = s.y1 - s.y0, len2 = dx * dx + dy * dy;
+                t = len2 > 0 ? min(1.0, max(0.0, ((x - s.x0) * dx + (y - s.y0) * dy) / len2)) : 0;
+                return i;
+            }
+            const Box &b = levels[level][i];
+            for (int k = b.first; k < b.first + b.count; k++)
+            {
+                if (level > 0)
+                {
+                    pq.push({boxDist(levels[level - 1][k], x, y), level - 1, k});
+                    continue;
+                }
+                const RoadSegment &s = segments[k];
+                if (!allow(s))
+                    continue;
+                double dx = s.x1 - s.x0, dy = s.y1 - s.y0, len2 = dx * dx + dy * dy;
+                double st = len2 > 0 ? min(1.0, max(0.0, ((x - s.x0) * dx + (y - s.y0) * dy) / len2)) : 0;
+                double px = s.x0 + st * dx - x, py = s.y0 + st * dy - y;
+                pq.push({sqrt(px * px + py * py), -1, k});
+            }
+        }
+        return -1;
     }
-}
+};
 
 // Link Stations to Nearest Road
+// Each station snaps to the closest point on a road polyline (within 500 m). The road edge is split there,
+// both directions, and a walking link joins the station to the new node.
 void linkStationsToRoads()
 {
-    int count = 0;
-    for (auto &node : nodes)
+    // Index one direction of every road edge (u < v); the paired v -> u copy is split alongside it
+    SegmentTree tree;
+    double minLat = INF, maxLat = -INF;
+    for (const auto &node : nodes)
+        minLat = min(minLat, node.lat), maxLat = max(maxLat, node.lat);
+    tree.cosRef = nodes.empty() ? 1 : cos(toRadians((minLat + maxLat) / 2));
+    vector<RoadSegment> segs;
+    for (const auto &[u, edges] : adj)
+        for (size_t slot = 0; slot < edges.size(); slot++)
+        {
+            const Edge &e = edges[slot];
+            if (e.type != ROAD || u >= e.to_node_id)
+                continue;
+            for (size_t i = 0; i + 1 < e.geometry.size(); i++)
+                segs.push_back({u, (int)slot, (int)i, tree.kmX(e.geometry[i].lon), tree.kmY(e.geometry[i].lat),
+                                tree.kmX(e.geometry[i + 1].lon), tree.kmY(e.geometry[i + 1].lat)});
+        }
+    tree.build(move(segs));
+
+    // Snap every station first, so several stations on one edge cut it in a single pass
+    struct Cut
+    {
+        int piece;
+        double t;
+        int station;
+        Point at;
+    };
+    map<pair<int, int>, vector<Cut>> cuts; // (u, slot) -> cuts along that edge
+    size_t named = nodes.size();
+    for (size_t id = 0; id < named; id++)
     {
+        const Node &node = nodes[id];
         if (node.name.empty())
             continue; // Skip if not a station (roughly)
 
-        int nearest = -1;
-        double minDist = INF;
+        double t = 0;
+        int k = tree.nearest(tree.kmX(node.lon), tree.kmY(node.lat), 0.5, [&](const RoadSegment &s)
+                             { return s.u != node.id && adj[s.u][s.slot].to_node_id != node.id; }, t);
+        if (k == -1)
+            continue;
+        const RoadSegment &s = tree.segments[k];
+        GeomRef g = adj[s.u][s.slot].geometry;
+        int piece = s.piece;
+        if (t >= 1 && piece + 2 < (int)g.size()) // an inner vertex is always the start of the next piece
+            piece++, t = 0;
+        Point a = g[piece], b = g[piece + 1];
+        Point at = {a.lat + t * (b.lat - a.lat), a.lon + t * (b.lon - a.lon)};
+        if (getDistance(node.lat, node.lon, at.lat, at.lon) < 0.5) // < 500m
+            cuts[{s.u, s.slot}].push_back({piece, t, node.id, at});
+    }
 
-        // Find nearest unnamed node (Road intersection)
-        for (auto &other : nodes)
-        {
-            if (node.id == other.id || !other.name.empty())
-                continue;
+    int count = 0;
+    map<int, vector<int>> removed; // node -> adj slots replaced by split pieces
+    for (auto &[key, list] : cuts)
+    {
+        auto [u, slot] = key;
+        Edge e = adj[u][slot];
+        int v = e.to_node_id;
+        vector<Point> line = polylinePoints(e.geometry);
+        sort(list.begin(), list.end(), [](const Cut &a, const Cut &b) { return tie(a.piece, a.t) < tie(b.piece, b.t); });
 
-            double d = getDistance(node.lat, node.lon, other.lat, other.lon);
-            if (d < minDist)
+        // Cut points become new nodes, never merged with whatever else lies nearby: cuts at a polyline end
+        // reuse that endpoint, and stations cutting at the same point share one node
+        double total = polylineDistance(line, 0, line.size() - 1);
+        vector<Point> geom = {line[0]};
+        int prev = u;
+        const Cut *prevCut = nullptr; // cut that created prev
+        size_t next = 1;              // next polyline vertex not yet copied
+        vector<pair<int, vector<Point>>> pieces;
+        for (const auto &c : list)
+        {
+            for (; next <= (size_t)c.piece; next++)
+                geom.push_back(line[next]);
+            int at;
+            if (c.piece == 0 && c.t <= 0)
+                at = u;
+            else if (c.piece + 2 == (int)line.size() && c.t >= 1)
+                at = v;
+            else if (prevCut && prevCut->piece == c.piece && prevCut->t == c.t)
+                at = prev;
+            else
+                at = createNode(c.at.lat, c.at.lon);
+            if (at != u && at != v && at != prev)
             {
-                minDist = d;
-                nearest = other.id;
+                geom.push_back(c.at);
+                pieces.push_back({at, geom});
+                geom = {c.at};
+                prev = at;
+                prevCut = &c;
             }
+            if (at == c.station)
+                continue; // never link a station to itself
+            vector<Point> link = {{nodes[c.station].lat, nodes[c.station].lon}, {nodes[at].lat, nodes[at].lon}};
+            addEdge(c.station, at, getDistance(link[0].lat, link[0].lon, link[1].lat, link[1].lon), WALKING, link);
+            count++;
         }
+        if (pieces.empty())
+            continue;
+        for (; next < line.size(); next++)
+            geom.push_back(line[next]);
+        pieces.push_back({v, geom});
 
-        if (nearest != -1 && minDist < 0.5)
-        { // < 500m
-            vector<Point> geom = {{node.lat, node.lon}, {nodes[nearest].lat, nodes[nearest].lon}};
-            addEdge(node.id, nearest, minDist, WALKING, geom);
-            count++;
+        // Replace u -> v and its reverse copy (same pooled polyline, left unused) with the pieces;
+        // weights keep the listed length, split by arc length
+        removed[u].push_back(slot);
+        for (size_t r = 0; r < adj[v].size(); r++)
+        {
+            const Edge &o = adj[v][r];
+            if (o.to_node_id == u && o.type == ROAD && o.geometry.start == e.geometry.start &&
+                find(removed[v].begin(), removed[v].end(), (int)r) == removed[v].end())
+            {
+                removed[v].push_back((int)r);
+                break;
+            }
         }
+        int from = u;
+        for (auto &[to, g] : pieces)
+        {
+            double len = polylineDistance(g, 0, g.size() - 1);
+            double w = total > 0 ? e.weight_distance * len / total : e.weight_distance / pieces.size();
+            addEdge(from, to, w, ROAD, g);
+            from = to;
+        }
+    }
+    for (auto &[u, slots] : removed)
+    {
+        sort(slots.rbegin(), slots.rend());
+        for (int slot : slots)
+            adj[u].erase(adj[u].begin() + slot);
     }
     cout << "Linked " << count << " stations to road network." << endl;
 }
+
+void clearGraphCaches(); // ContractionHierarchy.cpp, after the caches it clears
+
+bool graphDerived = false; // finalizeGraph() has run on the current CSR arrays
+
+// Edge sources and the reverse adjacency
+void buildReverseView()
+{
+    size_t n = nodes.size(), m = graph.targets.size();
+    graph.sources.resize(m);
+    for (size_t u = 0; u < n; u++)
+        for (int e = graph.offsets[u]; e < graph.offsets[u + 1]; e++)
+            graph.sources[e] = (int)u;
+
+    graph.in_offsets.assign(n + 1, 0);
+    for (size_t e = 0; e < m; e++)
+        graph.in_offsets[graph.targets[e] + 1]++;
+    for (size_t v = 0; v < n; v++)
+        graph.in_offsets[v + 1] += graph.in_offsets[v];
+    graph.in_edges.resize(m);
+    vector<int> fill(graph.in_offsets.begin(), graph.in_offsets.end() - 1);
+    for (size_t e = 0; e < m; e++)
+        graph.in_edges[fill[graph.targets[e]]++] = (int)e;
+}
+
+// Derived views over the CSR arrays: the reverse view, per-type stretch bounds and the chain-compressed
+// search graph. Caches built on an earlier graph are dropped; the traffic overlay is left to the caller.
+void finalizeGraph()
+{
+    clearGraphCaches();
+    buildReverseView();
+    size_t m = graph.targets.size();
+
+    // Some roadmap rows list a length shorter than the straight line between their endpoints,
+    // so haversine is only a lower bound once scaled by the smallest ratio seen per type
+    graph.min_stretch.fill(1.0);
+    vector<double> from[2], to[2], straight(m);
+    for (int k = 0; k < 2; k++)
+        from[k].resize(m), to[k].resize(m);
+    for (size_t e = 0; e < m; e++)
+    {
+        const Node &a = nodes[graph.sources[e]], &b = nodes[graph.targets[e]];
+        from[0][e] = a.lat, from[1][e] = a.lon, to[0][e] = b.lat, to[1][e] = b.lon;
+    }
+    haversinePairs(from[0].data(), from[1].data(), to[0].data(), to[1].data(), m, straight.data());
+    for (size_t e = 0; e < m; e++)
+        if (straight[e] > 0)
+            graph.min_stretch[graph.types[e]] = min(graph.min_stretch[graph.types[e]], graph.weights[e] / straight[e]);
+
+    buildSearchGraph();
+    graphDerived = true;
+}
+
+// Freeze adj into the CSR graph once loading and linking are done. derive = false stops after the
+// reverse view, for a renumberNodes() that follows and derives the rest once, under the final ids.
+void buildGraph(bool derive = true)
+{
+    graph = Graph();
+    graph.offsets.assign(nodes.size() + 1, 0);
+    for (const auto &[u, edges] : adj)
+        graph.offsets[u + 1] = (int)edges.size();
+    for (size_t u = 0; u < nodes.size(); u++)
+        graph.offsets[u + 1] += graph.offsets[u];
+
+    size_t m = graph.offsets.back();
+    graph.targets.reserve(m);
+    graph.weights.reserve(m);
+    graph.types.reserve(m);
+    graph.geometry.reserve(m);
+    for (auto &[u, edges] : adj)
+        for (auto &e : edges)
+        {
+            graph.targets.push_back(e.to_node_id);
+            graph.weights.push_back(e.weight_distance);
+            graph.types.push_back(e.type);
+            graph.geometry.push_back(e.geometry);
+        }
+    releaseBuildStorage();
+    publishTraffic(make_shared<TrafficOverlay>()); // a fresh graph starts without overrides
+    graphDerived = false;
+    if (derive)
+        finalizeGraph();
+    else
+        buildReverseView();
+}
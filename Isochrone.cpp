@@ -0,0 +1,272 @@
+// Isochrone.cpp: Isochrones / Reachability
+// One time-dependent sweep per origin, cut off at the largest band, gives every node reachable by a
+// departure time. Each band's nodes are rasterized onto a coarse grid and the cell outlines traced
+// into polygons (outer rings plus holes) for KML.
+#include <bits/stdc++.h>
+using namespace std;
+
+const double ISO_CELL_M = 200; // grid cell edge; coarser merges nearby nodes into one area
+
+struct IsochroneBand
+{
+    double minutes = 0;
+    int nodes = 0;                         // reachable nodes within the band
+    vector<vector<vector<Point>>> polygons; // each polygon: outer ring, then its holes (closed rings)
+};
+
+struct Isochrone
+{
+    int origin = -1; // snapped node, -1 when snapping failed
+    double start_time = 0;
+    vector<pair<int, double>> reached; // (node, minutes after start_time), ascending by minutes
+    vector<IsochroneBand> bands;       // ascending by minutes
+};
+
+// Section: Boundary tracing
+// Cell sides between a marked and an unmarked cell are directed with the marked cell on the left, so
+// chaining them gives counter-clockwise outer rings and clockwise holes.
+vector<vector<vector<Point>>> tracePolygons(const vector<Point> &points)
+{
+    vector<vector<vector<Point>>> polygons;
+    if (points.empty())
+        return polygons;
+
+    double minLat = INF, minLon = INF, maxLat = -INF, maxLon = -INF;
+    for (const auto &p : points)
+    {
+        minLat = min(minLat, p.lat), maxLat = max(maxLat, p.lat);
+        minLon = min(minLon, p.lon), maxLon = max(maxLon, p.lon);
+    }
+    double dLat = ISO_CELL_M / 111320.0;
+    double dLon = dLat / cos((minLat + maxLat) / 2 * M_PI / 180);
+    // One empty cell of padding on every side keeps all outlines closed
+    double lat0 = minLat - dLat, lon0 = minLon - dLon;
+    int W = (int)((maxLon - lon0) / dLon) + 2, H = (int)((maxLat - lat0) / dLat) + 2;
+    vector<char> cell((size_t)W * H, 0);
+    for (const auto &p : points)
+        cell[(size_t)(int)((p.lat - lat0) / dLat) * W + (int)((p.lon - lon0) / dLon)] = 1;
+    auto marked = [&](int x, int y) { return x >= 0 && y >= 0 && x < W && y < H && cell[(size_t)y * W + x]; };
+
+    // Up to two outgoing sides per grid vertex (two only where cells touch diagonally)
+    int VW = W + 1;
+    vector<array<int, 2>> out((size_t)VW * (H + 1), {-1, -1});
+    auto addSide = [&](int x0, int y0, int x1, int y1)
+    {
+        auto &slot = out[(size_t)y0 * VW + x0];
+        slot[slot[0] == -1 ? 0 : 1] = y1 * VW + x1;
+    };
+    for (int y = 0; y < H; y++)
+        for (int x = 0; x < W; x++)
+        {
+            if (!marked(x, y))
+                continue;
+            if (!marked(x, y - 1))
+                addSide(x, y, x + 1, y);
+            if (!marked(x + 1, y))
+                addSide(x + 1, y, x + 1, y + 1);
+            if (!marked(x, y + 1))
+                addSide(x + 1, y + 1, x, y + 1);
+            if (!marked(x - 1, y))
+                addSide(x, y + 1, x, y);
+        }
+
+    // Chain sides into rings; at a diagonal touch take the left turn so the two cells stay apart
+    struct Ring
+    {
+        vector<pair<int, int>> v; // grid vertices, corners only
+        double area;              // signed, in cells
+    };
+    vector<Ring> outers, holes;
+    for (size_t s = 0; s < out.size(); s++)
+        while (out[s][0] != -1)
+        {
+            vector<pair<int, int>> ring;
+            int cur = (int)s, dx = 0, dy = 0;
+            while (true)
+            {
+                auto &slot = out[cur];
+                int pick = 0;
+                if (slot[1] != -1)
+                {
+                    int nx = slot[1] % VW - cur % VW, ny = slot[1] / VW - cur / VW;
+                    pick = dx * ny - dy * nx > 0 ? 1 : 0;
+                }
+                int next = slot[pick];
+                slot[pick] = slot[1 - pick], slot[1] = -1;
+                int ndx = next % VW - cur % VW, ndy = next / VW - cur / VW;
+                if (ndx != dx || ndy != dy)
+                    ring.push_back({cur % VW, cur / VW});
+                dx = ndx, dy = ndy;
+                cur = next;
+                if (cur == (int)s)
+                    break;
+            }
+            double area = 0;
+            for (size_t i = 0; i < ring.size(); i++)
+            {
+                auto [x0, y0] = ring[i];
+                auto [x1, y1] = ring[(i + 1) % ring.size()];
+                area += (double)x0 * y1 - (double)x1 * y0;
+            }
+            (area > 0 ? outers : holes).push_back({ring, area / 2});
+        }
+
+    auto inside = [](const Ring &r, double px, double py)
+    {
+        bool in = false;
+        for (size_t i = 0, j = r.v.size() - 1; i < r.v.size(); j = i++)
+        {
+            double xi = r.v[i].first, yi = r.v[i].second, xj = r.v[j].first, yj = r.v[j].second;
+            if ((yi > py) != (yj > py) && px < (xj - xi) * (py - yi) / (yj - yi) + xi)
+                in = !in;
+        }
+        return in;
+    };
+    auto toPoints = [&](const Ring &r)
+    {
+        vector<Point> ring;
+        for (auto [x, y] : r.v)
+            ring.push_back({lat0 + y * dLat, lon0 + x * dLon});
+        ring.push_back(ring.front());
+        return ring;
+    };
+
+    for (const auto &r : outers)
+        polygons.push_back({toPoints(r)});
+    for (const auto &h : holes)
+    {
+        // A marked cell just across the hole's first side lies in exactly one outer ring's interior;
+        // nested islands make several rings contain it, and the smallest is the right one
+        auto [x0, y0] = h.v[0];
+        auto [x1, y1] = h.v[1];
+        double sx = (x1 > x0) - (x1 < x0), sy = (y1 > y0) - (y1 < y0);
+        double px = x0 + sx * 0.5 - sy * 0.5, py = y0 + sy * 0.5 + sx * 0.5;
+        int owner = -1;
+        for (size_t i = 0; i < outers.size(); i++)
+            if (inside(outers[i], px, py) && (owner == -1 || outers[i].area < outers[owner].area))
+                owner = (int)i;
+        if (owner != -1)
+            polygons[owner].push_back(toPoints(h));
+    }
+    return polygons;
+}
+
+// Section: Queries
+// Minimum-time reachability under problem pid's modes, speeds and schedules (P4 / P5)
+Isochrone computeIsochrone(int origin, double start_time, const vector<double> &minutes, int pid)
+{
+    Isochrone iso;
+    iso.origin = origin;
+    iso.start_time = start_time;
+    for (double m : minutes)
+    {
+        IsochroneBand band;
+        band.minutes = m;
+        iso.bands.push_back(band);
+    }
+    if (origin == -1 || minutes.empty())
+        return iso;
+
+    ProblemSpec spec = problemSpec(pid);
+    STAT(SearchStats stats;)
+    vector<ChainSlice> slices;
+    SearchWorkspace &ws = timeDependentSweep(origin, start_time, 1, typeTable(spec.rates), typeTable(spec.speeds),
+                                             modeMask(spec.modes), pid, -1, minutes.back() / 60, slices STAT(, stats));
+    for (size_t v = 0; v < nodes.size(); v++)
+        if (ws.distOf((int)v) != INF)
+            iso.reached.push_back({(int)v, ws.dist[v] * 60});
+    // Ties by load-order id keep the CSV the same under any node order
+    sort(iso.reached.begin(), iso.reached.end(), [](const auto &a, const auto &b)
+         { return a.second != b.second ? a.second < b.second : originalId(a.first) < originalId(b.first); });
+
+    size_t k = 0;
+    vector<Point> points;
+    for (auto &band : iso.bands)
+    {
+        for (; k < iso.reached.size() && iso.reached[k].second <= band.minutes; k++)
+            points.push_back({nodes[iso.reached[k].first].lat, nodes[iso.reached[k].first].lon});
+        band.nodes = (int)k;
+        band.polygons = tracePolygons(points);
+    }
+    return iso;
+}
+
+// Origins are independent sweeps, one thread workspace each
+vector<Isochrone> computeIsochrones(const vector<Point> &origins, double start_time, vector<double> minutes, int pid,
+                                    int threads)
+{
+    sort(minutes.begin(), minutes.end());
+    vector<Isochrone> result(origins.size());
+    parallelFor(origins.size(), threads, [&](size_t i)
+                { result[i] = computeIsochrone(getNearestNode(origins[i].lat, origins[i].lon), start_time, minutes, pid); });
+    return result;
+}
+
+// Section: Output
+// Bands are drawn largest first so the inner ones stay visible on top
+void exportIsochroneKML(const Isochrone &iso, string file)
+{
+    const vector<string> palette = {"7f00ff00", "7f00ffff", "7f0080ff", "7f0000ff", "7fff00ff"}; // aabbggrr
+    ofstream kml(file);
+    kml << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<kml xmlns=\"http://earth.google.com/kml/2.1\">\n<Document>\n";
+    for (size_t b = 0; b < iso.bands.size(); b++)
+        kml << "<Style id=\"b" << b << "\"><LineStyle><color>ff000000</color><width>1</width></LineStyle><PolyStyle><color>"
+            << palette[min(b, palette.size() - 1)] << "</color></PolyStyle></Style>\n";
+    if (iso.origin != -1)
+        kml << "<Placemark><name>Origin " << formatTime(iso.start_time) << "</name><Point><coordinates>" << fixed
+            << setprecision(6) << nodes[iso.origin].lon << "," << nodes[iso.origin].lat << ",0</coordinates></Point></Placemark>\n";
+
+    for (size_t b = iso.bands.size(); b-- > 0;)
+    {
+        const IsochroneBand &band = iso.bands[b];
+        kml << "<Placemark><name>" << defaultfloat << band.minutes << " min (" << band.nodes << " nodes)</name><styleUrl>#b" << b
+            << "</styleUrl><MultiGeometry>\n";
+        for (const auto &poly : band.polygons)
+        {
+            kml << "<Polygon>";
+            for (size_t r = 0; r < poly.size(); r++)
+            {
+                kml << (r == 0 ? "<outerBoundaryIs>" : "<innerBoundaryIs>") << "<LinearRing><coordinates>\n";
+                for (const auto &p : poly[r])
+                    kml << fixed << setprecision(6) << p.lon << "," << p.lat << ",0\n";
+                kml << "</coordinates></LinearRing>" << (r == 0 ? "</outerBoundaryIs>" : "</innerBoundaryIs>");
+            }
+            kml << "</Polygon>\n";
+        }
+        kml << "</MultiGeometry></Placemark>\n";
+    }
+    kml << "</Document></kml>";
+    kml.close();
+    cout << "Exported " << file << endl;
+}
+
+// Reachable set CSV: origin index, node, position and minutes after departure
+void writeIsochrones(const vector<Isochrone> &isos, ostream &out)
+{
+    out << "origin,node,lat,lon,minutes\n" << fixed << setprecision(6);
+    for (size_t i = 0; i < isos.size(); i++)
+        for (auto [v, m] : isos[i].reached)
+            out << i << "," << originalId(v) << "," << nodes[v].lat << "," << nodes[v].lon << "," << setprecision(2) << m
+                << setprecision(6) << "\n";
+    out.flush();
+}
+
+// Isochrone mode driver: reachable sets to out, one KML per origin
+void runIsochrones(int pid, istream &originsIn, ostream &out, double start_time, const vector<double> &minutes, int threads)
+{
+    vector<Point> origins = readPoints(originsIn);
+    auto t0 = chrono::steady_clock::now();
+    vector<Isochrone> isos = computeIsochrones(origins, start_time, minutes, pid, threads);
+    cerr << "Isochrones: " << origins.size() << " origins on " << threads << " threads in " << fixed << setprecision(3)
+         << chrono::duration<double>(chrono::steady_clock::now() - t0).count() << " s" << endl;
+    writeIsochrones(isos, out);
+    for (size_t i = 0; i < isos.size(); i++)
+    {
+        if (isos[i].origin == -1)
+        {
+            cerr << "Skipping origin " << i << ": no node nearby" << endl;
+            continue;
+        }
+        exportIsochroneKML(isos[i], "isochrone_" + to_string(i) + ".kml");
+    }
+}
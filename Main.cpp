@@ -1,100 +1,326 @@
 // Main.cpp: Unity Build Driver
 
 #include "DataLoader.cpp"
+#include "NodeOrder.cpp"
+#include "Snapshot.cpp"
 #include "Solver.cpp"
+#include "Raptor.cpp"
+#include "ContractionHierarchy.cpp"
+#include "Traffic.cpp"
+#include "Batch.cpp"
+#include "Matrix.cpp"
+#include "Isochrone.cpp"
+
+STAT(double snapMs = 0;)
+
+// Export, then emit the query's stats record (only in -DSEARCH_STATS builds)
+void finishRun([[maybe_unused]] int pid, SolutionPath &p, const string &file, const string &color)
+{
+    STAT(auto t0 = chrono::steady_clock::now();)
+    exportKML(p, file, color);
+    STAT(p.stats.export_ms = msSince(t0); p.stats.snap_ms = snapMs;
+         cerr << statsRecord("problem=" + to_string(pid), p.stats);)
+}
 
 void runP1(int s, int e)
 {
     cout << "=== Problem 1: Shortest Distance (Car) ===" << endl;
-    map<EdgeType, double> cost;
-    cost[ROAD] = 1;
-    vector<EdgeType> m = {ROAD};
-    SolutionPath p = dijkstra_standard(s, e, false, cost, m);
+    SolutionPath p = solveProblem(1, s, e, -1);
     printPathDescription(p, -1, {}, {}, 1);
-    exportKML(p, "solution_p1.kml", "ff0000ff");
+    finishRun(1, p, "solution_p1.kml", "ff0000ff");
 }
 
 void runP2(int s, int e)
 {
     cout << "=== Problem 2: Cheapest (Car, Metro) ===" << endl;
-    map<EdgeType, double> cost;
-    cost[ROAD] = 20;
-    cost[METRO] = 5;
-    cost[WALKING] = 0;
-    vector<EdgeType> m = {ROAD, METRO, WALKING};
-    SolutionPath p = dijkstra_standard(s, e, true, cost, m);
-    printPathDescription(p, -1, cost, {}, 2);
-    exportKML(p, "solution_p2.kml", "ffff0000");
+    SolutionPath p = solveProblem(2, s, e, -1);
+    printPathDescription(p, -1, problemSpec(2).rates, {}, 2);
+    finishRun(2, p, "solution_p2.kml", "ffff0000");
 }
 
 void runP3(int s, int e)
 {
     cout << "=== Problem 3: Cheapest (Car, Metro, Bus) ===" << endl;
-    map<EdgeType, double> cost;
-    cost[ROAD] = 20;
-    cost[METRO] = 5;
-    cost[BUS_BIKOLPO] = 7;
-    cost[BUS_UTTARA] = 7;
-    cost[WALKING] = 0;
-    vector<EdgeType> m = {ROAD, METRO, BUS_BIKOLPO, BUS_UTTARA, WALKING};
-    SolutionPath p = dijkstra_standard(s, e, true, cost, m);
-    printPathDescription(p, -1, cost, {}, 3);
-    exportKML(p, "solution_p3.kml", "ff00ff00");
+    SolutionPath p = solveProblem(3, s, e, -1);
+    printPathDescription(p, -1, problemSpec(3).rates, {}, 3);
+    finishRun(3, p, "solution_p3.kml", "ff00ff00");
 }
 
 void runP4(int s, int e, double st)
 {
     cout << "=== Problem 4: Cheapest with Start Time ===" << endl;
-    map<EdgeType, double> cost;
-    cost[ROAD] = 20;
-    cost[METRO] = 5;
-    cost[BUS_BIKOLPO] = 7;
-    cost[BUS_UTTARA] = 7;
-    cost[WALKING] = 0;
-    map<EdgeType, double> speed;
-    speed[ROAD] = 30;
-    speed[METRO] = 30;
-    speed[BUS_BIKOLPO] = 30;
-    speed[BUS_UTTARA] = 30;
-    speed[WALKING] = 2;
-    vector<EdgeType> m = {ROAD, METRO, BUS_BIKOLPO, BUS_UTTARA, WALKING};
-
-    SolutionPath p = dijkstra_time_dependent(s, e, st, 0, cost, speed, m, 4);
-    printPathDescription(p, st, cost, speed, 4);
-    exportKML(p, "solution_p4.kml", "ff00ffff");
+    ProblemSpec spec = problemSpec(4);
+    SolutionPath p = solveProblem(4, s, e, st);
+    printPathDescription(p, st, spec.rates, spec.speeds, 4);
+    finishRun(4, p, "solution_p4.kml", "ff00ffff");
 }
 
 void runP5(int s, int e, double st)
 {
     cout << "=== Problem 5: Fastest with Start Time ===" << endl;
-    map<EdgeType, double> cost;
-    cost[ROAD] = 20;
-    cost[METRO] = 5;
-    cost[BUS_BIKOLPO] = 7;
-    cost[BUS_UTTARA] = 7;
-    cost[WALKING] = 0;
-    map<EdgeType, double> speed;
-    speed[ROAD] = 10;
-    speed[METRO] = 10;
-    speed[BUS_BIKOLPO] = 10;
-    speed[BUS_UTTARA] = 10;
-    speed[WALKING] = 2;
-    vector<EdgeType> m = {ROAD, METRO, BUS_BIKOLPO, BUS_UTTARA, WALKING};
-
-    SolutionPath p = dijkstra_time_dependent(s, e, st, 1, cost, speed, m, 5);
-    printPathDescription(p, st, cost, speed, 5);
-    exportKML(p, "solution_p5.kml", "ff800080");
+    ProblemSpec spec = problemSpec(5);
+    SolutionPath p = solveProblem(5, s, e, st);
+    printPathDescription(p, st, spec.rates, spec.speeds, 5);
+    finishRun(5, p, "solution_p5.kml", "ff800080");
+}
+
+void runP6(int s, int e, double st)
+{
+    cout << "=== Problem 6: Transit Journeys (Arrival, Transfers, Fare) ===" << endl;
+    ProblemSpec spec = problemSpec(5);
+    RaptorParams params;
+    params.rates = spec.rates;
+    params.speeds = spec.speeds;
+    vector<Journey> journeys = raptorQuery(s, e, st, params);
+    printJourneys(journeys);
+    if (!journeys.empty())
+        exportKML(journeyPath(journeys.front(), s), "solution_p6.kml", "ff0080ff");
 }
 
+void runP6Profile(int s, int e, double from, double to)
+{
+    cout << "=== Problem 6: Departure Profile " << formatTime(from) << " - " << formatTime(to) << " ===" << endl;
+    ProblemSpec spec = problemSpec(5);
+    RaptorParams params;
+    params.rates = spec.rates;
+    params.speeds = spec.speeds;
+    printProfile(raptorProfile(s, e, from, to, params));
+}
 
-int main()
+void usage()
 {
+    cerr << "Usage: main                                  interactive demo\n"
+            "       main --batch <queries|-> <results|-> [--threads N]\n"
+            "       main --matrix <problem 1-3> <origins> <destinations> <results|-> [--threads N] [--path I J]...\n"
+            "       main --isochrone <problem 4-5> <origins> <results|-> [--at HH:MM] [--minutes 30,45,60] [--threads N]\n"
+            "       any mode also takes --traffic <feed> (applied after loading)\n"
+            "       and --order hilbert|bfs|load (node numbering for cache locality, default hilbert)\n";
+}
+
+int main(int argc, char **argv)
+{
+    // Batch mode: --batch <queries> <results> [--threads N]; "-" means stdin / stdout
+    // Matrix mode: --matrix <problem> <origins> <destinations> <results> [--threads N] [--path I J]...
+    // Isochrone mode: --isochrone <problem> <origins> <results> [--at HH:MM] [--minutes M,...] [--threads N]
+    // --traffic <feed> and --order <name> may appear anywhere; they are taken out before the mode arguments are parsed
+    auto takeOption = [&](const string &name, string &value)
+    {
+        for (int i = 1; i + 1 < argc; i++)
+            if (string(argv[i]) == name)
+            {
+                value = argv[i + 1];
+                for (int j = i; j + 2 <= argc; j++)
+                    argv[j] = argv[j + 2];
+                argc -= 2;
+                return;
+            }
+    };
+    string trafficFile, orderName = "hilbert";
+    takeOption("--traffic", trafficFile);
+    takeOption("--order", orderName);
+    NodeOrder order;
+    if (!parseNodeOrder(orderName, order))
+    {
+        usage();
+        return 2;
+    }
+    string mode = argc > 1 ? argv[1] : "";
+    bool batch = mode == "--batch", matrix = mode == "--matrix", isochrone = mode == "--isochrone";
+    string batchIn, batchOut, matrixFrom, matrixTo;
+    int matrixPid = 0;
+    vector<pair<size_t, size_t>> matrixPaths;
+    double isoStart = 17 + 43.0 / 60.0;
+    vector<double> isoMinutes = {30, 45, 60};
+    int threads = defaultThreadCount();
+    if (batch || matrix || isochrone)
+    {
+        int first = batch ? 4 : matrix ? 6 : 5;
+        if (argc < first)
+        {
+            usage();
+            return 2;
+        }
+        if (batch)
+        {
+            batchIn = argv[2];
+            batchOut = argv[3];
+        }
+        else if (isochrone)
+        {
+            matrixPid = atoi(argv[2]);
+            matrixFrom = argv[3];
+            batchOut = argv[4];
+            if (matrixPid < 4 || matrixPid > 5)
+            {
+                usage();
+                return 2;
+            }
+        }
+        else
+        {
+            matrixPid = atoi(argv[2]);
+            matrixFrom = argv[3];
+            matrixTo = argv[4];
+            batchOut = argv[5];
+            if (matrixPid < 1 || matrixPid > 3)
+            {
+                usage();
+                return 2;
+            }
+        }
+        for (int i = first; i < argc; i++)
+        {
+            if (string(argv[i]) == "--threads" && i + 1 < argc)
+                threads = max(1, atoi(argv[++i]));
+            else if (matrix && string(argv[i]) == "--path" && i + 2 < argc)
+            {
+                matrixPaths.push_back({(size_t)atol(argv[i + 1]), (size_t)atol(argv[i + 2])});
+                i += 2;
+            }
+            else if (isochrone && string(argv[i]) == "--at" && i + 1 < argc)
+            {
+                int hh = 0, mm = 0;
+                if (sscanf(argv[++i], "%d:%d", &hh, &mm) != 2)
+                {
+                    usage();
+                    return 2;
+                }
+                isoStart = hh + mm / 60.0;
+            }
+            else if (isochrone && string(argv[i]) == "--minutes" && i + 1 < argc)
+            {
+                isoMinutes.clear();
+                stringstream ss(argv[++i]);
+                for (string m; getline(ss, m, ',');)
+                    if (atof(m.c_str()) > 0)
+                        isoMinutes.push_back(atof(m.c_str()));
+                if (isoMinutes.empty())
+                {
+                    usage();
+                    return 2;
+                }
+            }
+            else
+            {
+                usage();
+                return 2;
+            }
+        }
+    }
+    else if (argc > 1)
+    {
+        usage();
+        return 2;
+    }
+
+    // Keep stdout clean for results when they are streamed there
+    streambuf *stdoutBuf = cout.rdbuf();
+    if ((batch || matrix || isochrone) && batchOut == "-")
+        cout.rdbuf(cerr.rdbuf());
+
     cout << "Loading Data..." << endl;
-    parseRoadMap("Dataset/Roadmap-Dhaka.csv");
-    parseRouteMap("Dataset/Routemap-DhakaMetroRail.csv", METRO);
-    parseRouteMap("Dataset/Routemap-BikolpoBus.csv", BUS_BIKOLPO);
-    parseRouteMap("Dataset/Routemap-UttaraBus.csv", BUS_UTTARA);
-    linkStationsToRoads();
+    const string snapshotFile = "Dataset/graph.snapshot";
+    const vector<string> sources = {"Dataset/Roadmap-Dhaka.csv", "Dataset/Routemap-DhakaMetroRail.csv",
+                                    "Dataset/Routemap-BikolpoBus.csv", "Dataset/Routemap-UttaraBus.csv"};
+    if (loadSnapshot(snapshotFile, sources, order))
+    {
+        cout << "Loaded Snapshot. Nodes: " << nodes.size() << ", Edges: " << graph.targets.size() << endl;
+    }
+    else
+    {
+        loadCsvSources(sources, threads);
+        linkStationsToRoads();
+        buildGraph(false); // renumberNodes() derives the search structures
+        renumberNodes(order);
+        if (!saveSnapshot(snapshotFile, sources))
+            cout << "Warning: could not write " << snapshotFile << endl;
+    }
+    buildSpatialIndex();
+
+    if (!trafficFile.empty())
+    {
+        ifstream feed(trafficFile);
+        if (!feed)
+        {
+            cerr << "Error: cannot open traffic feed " << trafficFile << "." << endl;
+            return 1;
+        }
+        try
+        {
+            printTrafficReport(applyTrafficFeed(feed));
+        }
+        catch (const invalid_argument &e)
+        {
+            cerr << "Error: " << e.what() << endl;
+            return 1;
+        }
+    }
+
+    if (batch)
+    {
+        ifstream fin;
+        ofstream fout;
+        if (batchIn != "-")
+            fin.open(batchIn);
+        if (batchOut != "-")
+            fout.open(batchOut);
+        if ((batchIn != "-" && !fin) || (batchOut != "-" && !fout))
+        {
+            cerr << "Error: cannot open batch input/output." << endl;
+            return 1;
+        }
+        ostream out(batchOut == "-" ? stdoutBuf : fout.rdbuf());
+        runBatch(batchIn == "-" ? cin : fin, out, threads);
+        return 0;
+    }
+
+    if (matrix)
+    {
+        ifstream fromIn(matrixFrom), toIn(matrixTo);
+        ofstream fout;
+        if (batchOut != "-")
+            fout.open(batchOut);
+        if (!fromIn || !toIn || (batchOut != "-" && !fout))
+        {
+            cerr << "Error: cannot open matrix input/output." << endl;
+            return 1;
+        }
+        ostream out(batchOut == "-" ? stdoutBuf : fout.rdbuf());
+        try
+        {
+            runMatrix(matrixPid, fromIn, toIn, out, threads, matrixPaths);
+        }
+        catch (const invalid_argument &e)
+        {
+            cerr << "Error: " << e.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    if (isochrone)
+    {
+        ifstream originsIn(matrixFrom);
+        ofstream fout;
+        if (batchOut != "-")
+            fout.open(batchOut);
+        if (!originsIn || (batchOut != "-" && !fout))
+        {
+            cerr << "Error: cannot open isochrone input/output." << endl;
+            return 1;
+        }
+        ostream out(batchOut == "-" ? stdoutBuf : fout.rdbuf());
+        try
+        {
+            runIsochrones(matrixPid, originsIn, out, isoStart, isoMinutes, threads);
+        }
+        catch (const invalid_argument &e)
+        {
+            cerr << "Error: " << e.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
 
     double sLat = 23.834145, sLon = 90.363833;
     double eLat = 23.721444, eLon = 90.378868;
@@ -124,8 +350,10 @@ int main()
         deadline = dh + dm / 60.0;
     }
 
+    STAT(auto snapStart = chrono::steady_clock::now();)
     int startNode = getNearestNode(sLat, sLon);
     int endNode = getNearestNode(eLat, eLon);
+    STAT(snapMs = msSince(snapStart);)
 
     if (startNode == -1 || endNode == -1)
     {
@@ -137,8 +365,8 @@ int main()
     double walkDst = getDistance(nodes[endNode].lat, nodes[endNode].lon, eLat, eLon);
 
     cout << fixed << setprecision(2);
-    cout << "Initial Walk: " << walkSrc << " km (" << (int)(walkSrc / 2.0 * 60) << " min) to Node " << startNode << endl;
-    cout << "Final Walk: " << walkDst << " km (" << (int)(walkDst / 2.0 * 60) << " min) from Node " << endNode << endl;
+    cout << "Initial Walk: " << walkSrc << " km (" << (int)(walkSrc / 2.0 * 60) << " min) to Node " << originalId(startNode) << endl;
+    cout << "Final Walk: " << walkDst << " km (" << (int)(walkDst / 2.0 * 60) << " min) from Node " << originalId(endNode) << endl;
 
     double gStart = startTime + walkSrc / 2.0;
     double gDead = deadline - walkDst / 2.0;
@@ -148,7 +376,8 @@ int main()
     runP3(startNode, endNode);
     runP4(startNode, endNode, gStart);
     runP5(startNode, endNode, gStart);
-    
+    runP6(startNode, endNode, gStart);
+    runP6Profile(startNode, endNode, gStart, gDead);
 
     return 0;
 }
@@ -0,0 +1,267 @@
+// Matrix.cpp: Many-to-Many Distance / Cost Matrices
+// Small matrices run one pruned Dijkstra sweep per row from the smaller side. Large ones use the
+// contraction hierarchy: one upward search per target fills buckets, one per source scans them.
+#include <bits/stdc++.h>
+using namespace std;
+
+struct OdMatrix
+{
+    int pid = 0;
+    vector<int> sources, targets;              // snapped node ids (-1 when snapping failed)
+    vector<double> values;                     // row-major sources x targets; INF when unreachable
+    shared_ptr<const ContractionHierarchy> ch; // set when the bucket engine was used
+
+    double at(size_t i, size_t j) const { return values[i * targets.size() + j]; }
+};
+
+// Below this many rows on the smaller side a sweep per row beats paying for a hierarchy
+const int MATRIX_CH_MIN_ROWS = 400;
+
+// One-to-many sweep: Dijkstra from src (backwards when reverse) until every wanted node is settled
+void sweepRow(int src, const Metric &metric, bool reverse, const vector<char> &wanted, int wantedCount,
+              const vector<int> &cols, double *row, size_t stride)
+{
+    SearchWorkspace &ws = threadWorkspace();
+    priority_queue<pair<double, int>, vector<pair<double, int>>, greater<pair<double, int>>> pq;
+    ws.begin();
+    ws.set(src, 0, -1);
+    pq.push({0, src});
+    auto traffic = currentTraffic();
+    const vector<double> &weights = traffic->routingWeights();
+    const vector<int> &offsets = reverse ? graph.in_offsets : graph.offsets;
+    int remaining = wantedCount;
+    while (!pq.empty() && remaining > 0)
+    {
+        auto [d, u] = pq.top();
+        pq.pop();
+        if (d > ws.dist[u])
+            continue;
+        remaining -= wanted[u];
+        for (int k = offsets[u]; k < offsets[u + 1]; k++)
+        {
+            int e = reverse ? graph.in_edges[k] : k;
+            if (!(metric.mask >> graph.types[e] & 1) || weights[e] == INF)
+                continue;
+            int v = reverse ? graph.sources[e] : graph.targets[e];
+            double nd = d + weights[e] * metric.factor[graph.types[e]];
+            if (nd < ws.distOf(v))
+            {
+                ws.set(v, nd, e);
+                pq.push({nd, v});
+            }
+        }
+    }
+    for (size_t j = 0; j < cols.size(); j++)
+        row[j * stride] = cols[j] == -1 ? INF : ws.distOf(cols[j]);
+}
+
+void sweepMatrix(OdMatrix &m, const Metric &metric, int threads)
+{
+    // Rows are the smaller side; a target-side sweep runs on the reverse graph and fills a column
+    bool byTarget = m.targets.size() < m.sources.size();
+    const vector<int> &rows = byTarget ? m.targets : m.sources;
+    const vector<int> &cols = byTarget ? m.sources : m.targets;
+    vector<char> wanted(nodes.size(), 0);
+    int wantedCount = 0;
+    for (int v : cols)
+        if (v != -1 && !wanted[v])
+            wanted[v] = 1, wantedCount++;
+
+    size_t width = m.targets.size();
+    parallelFor(rows.size(), threads, [&](size_t r)
+                {
+                    double *out = byTarget ? &m.values[r] : &m.values[r * width];
+                    size_t stride = byTarget ? width : 1;
+                    if (rows[r] == -1)
+                        for (size_t j = 0; j < cols.size(); j++)
+                            out[j * stride] = INF;
+                    else
+                        sweepRow(rows[r], metric, byTarget, wanted, wantedCount, cols, out, stride);
+                });
+}
+
+// Upward search over the hierarchy (down arcs backwards when reverse); calls visit(node, dist) per settled node
+template <typename Visit>
+void chUpwardSearch(const ContractionHierarchy &ch, int src, bool reverse, Visit visit)
+{
+    SearchWorkspace &ws = threadWorkspace();
+    priority_queue<pair<double, int>, vector<pair<double, int>>, greater<pair<double, int>>> pq;
+    ws.begin();
+    ws.set(src, 0, -1);
+    pq.push({0, src});
+    const vector<int> &offsets = reverse ? ch.down_offsets : ch.up_offsets;
+    const vector<int> &list = reverse ? ch.down_arcs : ch.up_arcs;
+    while (!pq.empty())
+    {
+        auto [d, u] = pq.top();
+        pq.pop();
+        if (d > ws.dist[u])
+            continue;
+        visit(u, d);
+        for (int k = offsets[u]; k < offsets[u + 1]; k++)
+        {
+            const CHArc &a = ch.arcs[list[k]];
+            int v = reverse ? a.from : a.to;
+            double nd = d + a.weight;
+            if (nd < ws.distOf(v))
+            {
+                ws.set(v, nd, list[k]);
+                pq.push({nd, v});
+            }
+        }
+    }
+}
+
+void bucketMatrix(OdMatrix &m, const ContractionHierarchy &ch, int threads)
+{
+    // Backward phase: every node a target's search settles gets a (target, dist) bucket entry
+    struct BucketEntry
+    {
+        int target;
+        double dist;
+    };
+    vector<vector<pair<int, BucketEntry>>> found(m.targets.size());
+    parallelFor(m.targets.size(), threads, [&](size_t j)
+                {
+                    if (m.targets[j] != -1)
+                        chUpwardSearch(ch, m.targets[j], true, [&](int u, double d)
+                                       { found[j].push_back({u, {(int)j, d}}); });
+                });
+
+    // Group entries by node (counting sort) so the forward phase reads one contiguous bucket per node
+    vector<int> bucketStart(nodes.size() + 1, 0);
+    for (const auto &list : found)
+        for (const auto &[u, entry] : list)
+            bucketStart[u + 1]++;
+    for (size_t v = 0; v < nodes.size(); v++)
+        bucketStart[v + 1] += bucketStart[v];
+    vector<BucketEntry> buckets(bucketStart.back());
+    vector<int> fill(bucketStart.begin(), bucketStart.end() - 1);
+    for (auto &list : found)
+    {
+        for (const auto &[u, entry] : list)
+            buckets[fill[u]++] = entry;
+        vector<pair<int, BucketEntry>>().swap(list);
+    }
+
+    // Forward phase: each source's upward search meets the buckets; rows are disjoint per worker
+    size_t width = m.targets.size();
+    parallelFor(m.sources.size(), threads, [&](size_t i)
+                {
+                    double *row = &m.values[i * width];
+                    std::fill(row, row + width, INF);
+                    if (m.sources[i] == -1)
+                        return;
+                    chUpwardSearch(ch, m.sources[i], false, [&](int u, double d)
+                                   {
+                                       for (int k = bucketStart[u]; k < bucketStart[u + 1]; k++)
+                                           row[buckets[k].target] = min(row[buckets[k].target], d + buckets[k].dist);
+                                   });
+                });
+}
+
+// Snap both point sets to their nearest nodes and fill the matrix under a static problem's metric (P1-P3)
+OdMatrix computeMatrix(int pid, const vector<Point> &from, const vector<Point> &to, int threads)
+{
+    ProblemSpec spec = problemSpec(pid);
+    if (spec.time_dependent)
+        throw invalid_argument("matrix: problem " + to_string(pid) + " is time-dependent");
+
+    OdMatrix m;
+    m.pid = pid;
+    for (const auto &p : from)
+        m.sources.push_back(getNearestNode(p.lat, p.lon));
+    for (const auto &p : to)
+        m.targets.push_back(getNearestNode(p.lat, p.lon));
+    m.values.assign(m.sources.size() * m.targets.size(), INF);
+    if (m.values.empty())
+        return m;
+
+    if ((int)min(m.sources.size(), m.targets.size()) >= MATRIX_CH_MIN_ROWS)
+    {
+        m.ch = buildContractionHierarchy(spec.opt_cost, spec.rates, spec.modes);
+        bucketMatrix(m, *m.ch, threads);
+    }
+    else
+        sweepMatrix(m, makeMetric(spec.opt_cost, spec.rates, spec.modes), threads);
+    return m;
+}
+
+// Full path behind one matrix entry, through the same engine that produced it
+SolutionPath matrixPath(const OdMatrix &m, size_t i, size_t j)
+{
+    int s = m.sources[i], e = m.targets[j];
+    if (s == -1 || e == -1)
+        return SolutionPath();
+    ProblemSpec spec = problemSpec(m.pid);
+    if (m.ch)
+        return chQuery(*m.ch, s, e, spec.rates);
+    return dijkstra_standard(s, e, spec.opt_cost, spec.rates, spec.modes);
+}
+
+// Points file: one "<lat> <lon>" per line; blank lines and '#' comments are skipped
+vector<Point> readPoints(istream &in)
+{
+    vector<Point> points;
+    string line;
+    for (int lineNo = 1; getline(in, line); lineNo++)
+    {
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == string::npos || line[first] == '#')
+            continue;
+        Point p;
+        istringstream ss(line);
+        if (!(ss >> p.lat >> p.lon))
+            throw invalid_argument("points line " + to_string(lineNo) + ": expected <lat> <lon>");
+        points.push_back(p);
+    }
+    return points;
+}
+
+// Dense CSV: header of target nodes, then one row per source (node id, values); "-" when unreachable
+void writeMatrix(const OdMatrix &m, ostream &out)
+{
+    out << "node";
+    for (int t : m.targets)
+        out << "," << originalId(t);
+    out << "\n" << fixed << setprecision(6);
+    for (size_t i = 0; i < m.sources.size(); i++)
+    {
+        out << originalId(m.sources[i]);
+        for (size_t j = 0; j < m.targets.size(); j++)
+        {
+            if (m.at(i, j) == INF)
+                out << ",-";
+            else
+                out << "," << m.at(i, j);
+        }
+        out << "\n";
+    }
+    out.flush();
+}
+
+// Matrix mode driver: writes the matrix, then describes and exports each requested pair
+void runMatrix(int pid, istream &fromIn, istream &toIn, ostream &out, int threads, const vector<pair<size_t, size_t>> &paths)
+{
+    vector<Point> from = readPoints(fromIn), to = readPoints(toIn);
+    auto t0 = chrono::steady_clock::now();
+    OdMatrix m = computeMatrix(pid, from, to, threads);
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    writeMatrix(m, out);
+    cerr << "Matrix: " << from.size() << " x " << to.size() << " (" << (m.ch ? "hierarchy buckets" : "row sweeps")
+         << ") on " << threads << " threads in " << fixed << setprecision(3) << secs << " s" << endl;
+
+    for (auto [i, j] : paths)
+    {
+        if (i >= m.sources.size() || j >= m.targets.size())
+        {
+            cerr << "Skipping path " << i << " " << j << ": out of range" << endl;
+            continue;
+        }
+        ProblemSpec spec = problemSpec(pid);
+        SolutionPath p = matrixPath(m, i, j);
+        printPathDescription(p, -1, spec.rates, {}, pid);
+        if (!p.nodes.empty())
+            exportKML(p, "matrix_" + to_string(i) + "_" + to_string(j) + ".kml", "ff0000ff");
+    }
+}
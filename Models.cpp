@@ -1,5 +1,6 @@
 // Models.cpp: Core Data Structures
 #include <bits/stdc++.h>
+#include "Haversine.cpp"
 using namespace std;
 
 // Constants
@@ -15,6 +16,7 @@ enum EdgeType
     BUS_UTTARA,
     WALKING
 };
+const int EDGE_TYPE_COUNT = 5;
 
 // Structs
 struct Point
@@ -22,24 +24,147 @@ struct Point
     double lat, lon;
 };
 
+// Geometry Pool: each polyline is stored once, as fixed-point coordinates (1e-7 degree, ~1 cm).
+// Both directions of an edge reference the same range; the back edge just reads it reversed.
+struct FixedPoint
+{
+    int32_t lat, lon;
+};
+vector<FixedPoint> geometryPool;
+
+struct GeomRef
+{
+    uint32_t start = 0;
+    uint32_t count : 31;
+    uint32_t reversed : 1;
+
+    GeomRef() : count(0), reversed(0) {}
+    GeomRef(uint32_t s, uint32_t c, bool r) : start(s), count(c), reversed(r) {}
+    size_t size() const { return count; }
+    GeomRef flipped() const { return GeomRef(start, count, !reversed); }
+    Point operator[](size_t i) const
+    {
+        const FixedPoint &p = geometryPool[start + (reversed ? count - 1 - i : i)];
+        return {p.lat / 1e7, p.lon / 1e7};
+    }
+};
+
+GeomRef storePolyline(const Point *points, size_t n)
+{
+    GeomRef ref((uint32_t)geometryPool.size(), (uint32_t)n, false);
+    for (size_t i = 0; i < n; i++)
+        geometryPool.push_back({(int32_t)llround(points[i].lat * 1e7), (int32_t)llround(points[i].lon * 1e7)});
+    return ref;
+}
+GeomRef storePolyline(const vector<Point> &polyline) { return storePolyline(polyline.data(), polyline.size()); }
+
+vector<Point> polylinePoints(GeomRef g)
+{
+    vector<Point> points;
+    points.reserve(g.size());
+    for (size_t i = 0; i < g.size(); i++)
+        points.push_back(g[i]);
+    return points;
+}
+
 struct Edge
 {
     int to_node_id;
     double weight_distance;
     EdgeType type;
-    vector<Point> geometry;
+    GeomRef geometry;
 };
 
+// Graph Arenas: loading bump-allocates from two monotonic arenas instead of making one heap
+// allocation per node, edge list and name. graphArena holds what lives as long as the graph (interned
+// names, the dedup index); buildArena holds the build-time adjacency and is dropped by buildGraph().
+pmr::monotonic_buffer_resource graphArena(1 << 20);
+pmr::monotonic_buffer_resource buildArena(4 << 20);
+
+// Name Pool: each distinct station name is stored once in graphArena; nodes hold views into it
+pmr::unordered_set<string_view> nameIndex(&graphArena);
+
+string_view internName(string_view name)
+{
+    if (name.empty())
+        return {};
+    auto it = nameIndex.find(name);
+    if (it != nameIndex.end())
+        return *it;
+    char *copy = (char *)graphArena.allocate(name.size(), 1);
+    memcpy(copy, name.data(), name.size());
+    return *nameIndex.insert(string_view(copy, name.size())).first;
+}
+
 struct Node
 {
     int id;
     double lat, lon;
-    string name;
+    string_view name; // interned, empty for road intersections
 };
 
 // Global Graph
 vector<Node> nodes;
-map<int, vector<Edge>> adj;
+pmr::map<int, pmr::vector<Edge>> adj(&buildArena); // build-time adjacency, moved into graph by buildGraph()
+
+// Load-Order Ids: nodes may be renumbered for locality (NodeOrder.cpp); users and traffic feeds keep
+// seeing the ids the CSV loader assigned. Both empty while the graph is in load order.
+vector<int> sourceId;   // node id -> load-order id
+vector<int> sourceNode; // load-order id -> node id
+
+int originalId(int v) { return v < 0 || sourceId.empty() ? v : sourceId[v]; } // -1 (no node) passes through
+int nodeOfOriginalId(int id) { return sourceNode.empty() ? id : sourceNode[id]; }
+
+void setOriginalIds(vector<int> ids)
+{
+    sourceId = move(ids);
+    sourceNode.assign(sourceId.size(), 0);
+    for (size_t v = 0; v < sourceId.size(); v++)
+        sourceNode[sourceId[v]] = (int)v;
+}
+
+// Drop the build-time adjacency and hand its arena blocks back in one go
+void releaseBuildStorage()
+{
+    adj.clear();
+    buildArena.release();
+}
+
+// Frozen Graph: compressed sparse row (CSR) layout the solvers run on
+struct Graph
+{
+    vector<int> offsets;            // node id -> first edge id; edges of u are [offsets[u], offsets[u + 1])
+    vector<int> targets;            // edge id -> to_node_id
+    vector<double> weights;         // edge id -> weight_distance
+    vector<EdgeType> types;         // edge id -> type
+    vector<GeomRef> geometry;       // edge id -> polyline in geometryPool, kept apart from the hot arrays
+
+    // Derived by finalizeGraph(), never stored in snapshots
+    vector<int> sources;                         // edge id -> from node
+    vector<int> in_offsets;                      // node id -> first slot in in_edges
+    vector<int> in_edges;                        // incoming edge ids grouped by target node
+    array<double, EDGE_TYPE_COUNT> min_stretch;  // per type: min weight / straight-line length, for A* bounds
+};
+Graph graph;
+
+// Traffic Overlay: live per-edge overrides on top of the frozen graph. Each version is immutable and
+// published atomically, so a query that loads it once sees one consistent state for its whole run.
+struct TrafficOverlay
+{
+    uint64_t version = 0;
+    vector<double> weights; // edge id -> static routing weight (>= graph.weights, INF when closed); empty = base
+    vector<float> speeds;   // edge id -> km/h for time-dependent travel, 0 = problem default; empty = none
+
+    const vector<double> &routingWeights() const { return weights.empty() ? graph.weights : weights; }
+    bool closed(int e) const { return !weights.empty() && weights[e] == INF; }
+    double speed(int e, double fallback) const { return speeds.empty() || speeds[e] == 0 ? fallback : speeds[e]; }
+};
+shared_ptr<const TrafficOverlay> trafficState = make_shared<TrafficOverlay>();
+
+shared_ptr<const TrafficOverlay> currentTraffic() { return atomic_load(&trafficState); }
+void publishTraffic(shared_ptr<const TrafficOverlay> next) { atomic_store(&trafficState, move(next)); }
+
+Edge getEdge(int e) { return {graph.targets[e], graph.weights[e], graph.types[e], graph.geometry[e]}; }
 
 // Helpers
 double toRadians(double degree) { return degree * PI / 180.0; }
@@ -56,9 +181,138 @@ double getDistance(double lat1, double lon1, double lat2, double lon2)
     return R * c;
 }
 
+// Length of the n-point polyline, through the batch kernel
+double polylineDistance(const Point *points, size_t n)
+{
+    thread_local vector<double> lats, lons;
+    lats.clear(), lons.clear();
+    for (size_t i = 0; i < n; i++)
+        lats.push_back(points[i].lat), lons.push_back(points[i].lon);
+    return haversinePolyline(lats.data(), lons.data(), n);
+}
+// Length of g between points from and to
+double polylineDistance(const vector<Point> &g, size_t from, size_t to)
+{
+    return from <= to && from < g.size() ? polylineDistance(g.data() + from, min(to, g.size() - 1) - from + 1) : 0;
+}
+double polylineDistance(const vector<Point> &g) { return polylineDistance(g.data(), g.size()); }
+
+// Spatial Index: uniform lat/lon grid over nodes, built once after loading
+struct NodeGrid
+{
+    double minLat = 0, minLon = 0, cellDeg = 1;
+    int rows = 0, cols = 0;
+    size_t nodeCount = 0;            // nodes.size() at build time; stale if it differs
+    double minCosLat = 1;            // cos of the largest |lat| in the grid (distance lower bound)
+    vector<int> cellStart;           // rows * cols + 1 offsets into cellNodes
+    vector<int> cellNodes;           // node ids grouped by cell, ascending within a cell
+    vector<double> cellLat, cellLon; // coordinates of cellNodes (SoA, for the distance kernel)
+};
+NodeGrid grid;
+
+int gridRow(double lat) { return (int)floor((lat - grid.minLat) / grid.cellDeg); }
+int gridCol(double lon) { return (int)floor((lon - grid.minLon) / grid.cellDeg); }
+bool gridReady() { return grid.nodeCount > 0 && grid.nodeCount == nodes.size(); }
+
+void buildSpatialIndex()
+{
+    grid = NodeGrid();
+    if (nodes.empty())
+        return;
+
+    double maxLat = -INF, maxLon = -INF;
+    grid.minLat = grid.minLon = INF;
+    for (const auto &n : nodes)
+    {
+        grid.minLat = min(grid.minLat, n.lat);
+        grid.minLon = min(grid.minLon, n.lon);
+        maxLat = max(maxLat, n.lat);
+        maxLon = max(maxLon, n.lon);
+    }
+
+    // Aim for ~4 nodes per cell
+    double area = max(maxLat - grid.minLat, 1e-6) * max(maxLon - grid.minLon, 1e-6);
+    grid.cellDeg = max(sqrt(area / max(1.0, nodes.size() / 4.0)), 1e-5);
+    grid.rows = gridRow(maxLat) + 1;
+    grid.cols = gridCol(maxLon) + 1;
+    grid.minCosLat = cos(toRadians(max(abs(grid.minLat), abs(maxLat))));
+
+    // Counting sort by cell keeps ids ascending inside each cell
+    grid.cellStart.assign((size_t)grid.rows * grid.cols + 1, 0);
+    for (const auto &n : nodes)
+        grid.cellStart[(size_t)gridRow(n.lat) * grid.cols + gridCol(n.lon) + 1]++;
+    for (size_t c = 1; c < grid.cellStart.size(); c++)
+        grid.cellStart[c] += grid.cellStart[c - 1];
+    grid.cellNodes.resize(nodes.size());
+    vector<int> fill(grid.cellStart.begin(), grid.cellStart.end() - 1);
+    for (const auto &n : nodes)
+        grid.cellNodes[fill[(size_t)gridRow(n.lat) * grid.cols + gridCol(n.lon)]++] = n.id;
+    grid.cellLat.resize(nodes.size());
+    grid.cellLon.resize(nodes.size());
+    for (size_t k = 0; k < nodes.size(); k++)
+        grid.cellLat[k] = nodes[grid.cellNodes[k]].lat, grid.cellLon[k] = nodes[grid.cellNodes[k]].lon;
+
+    grid.nodeCount = nodes.size();
+}
+
+// Node Deduplication: hash on 1e-6 quantized coordinates, maintained as nodes are created
+pmr::unordered_map<long long, int> dedupHead(&graphArena); // cell key -> newest node in that cell
+vector<int> dedupNext;                                     // node id -> previous node in the same cell, or -1
+
+long long dedupKey(long long row, long long col) { return (row + 100000000LL) * 400000000LL + (col + 200000000LL); }
+long long dedupCell(double deg) { return (long long)floor(deg * 1e6); }
+bool dedupReady() { return dedupNext.size() == nodes.size(); }
+
+void registerNode(int id)
+{
+    auto it = dedupHead.emplace(dedupKey(dedupCell(nodes[id].lat), dedupCell(nodes[id].lon)), id);
+    dedupNext.push_back(it.second ? -1 : it.first->second);
+    it.first->second = id;
+}
+
+int findDuplicateNode(double lat, double lon)
+{
+    // A match within the tolerance box can only sit in the cells that box spans
+    int found = -1;
+    for (long long r = dedupCell(lat - 1e-6); r <= dedupCell(lat + 1e-6); r++)
+        for (long long c = dedupCell(lon - 1e-6); c <= dedupCell(lon + 1e-6); c++)
+        {
+            auto it = dedupHead.find(dedupKey(r, c));
+            if (it == dedupHead.end())
+                continue;
+            for (int id = it->second; id != -1; id = dedupNext[id])
+                if (abs(nodes[id].lat - lat) < 1e-6 && abs(nodes[id].lon - lon) < 1e-6 && (found == -1 || id < found))
+                    found = id;
+        }
+    return found;
+}
+
 // Node Lookup
 int getNodeID(double lat, double lon)
 {
+    if (dedupReady())
+        return findDuplicateNode(lat, lon);
+
+    if (gridReady())
+    {
+        // Only the cells touched by the 1e-6 tolerance box can hold a match
+        int r0 = max(0, gridRow(lat - 1e-6)), r1 = min(grid.rows - 1, gridRow(lat + 1e-6));
+        int c0 = max(0, gridCol(lon - 1e-6)), c1 = min(grid.cols - 1, gridCol(lon + 1e-6));
+        int found = -1;
+        for (int r = r0; r <= r1; r++)
+            for (int c = c0; c <= c1; c++)
+            {
+                size_t cell = (size_t)r * grid.cols + c;
+                for (int k = grid.cellStart[cell]; k < grid.cellStart[cell + 1]; k++)
+                {
+                    const Node &node = nodes[grid.cellNodes[k]];
+                    if (abs(node.lat - lat) < 1e-6 && abs(node.lon - lon) < 1e-6 && (found == -1 || node.id < found))
+                        found = node.id;
+                }
+            }
+        return found;
+    }
+
     for (const auto &node : nodes)
     {
         if (abs(node.lat - lat) < 1e-6 && abs(node.lon - lon) < 1e-6)
@@ -71,28 +325,102 @@ int getNearestNode(double lat, double lon)
 {
     int nearest_id = -1;
     double min_dist = INF;
+    thread_local vector<double> dist;
 
-    for (const auto &node : nodes)
+    // Distances to a run of ids / coordinates in one kernel call; ties go to the lower id
+    auto scan = [&](const int *ids, const double *lats, const double *lons, size_t n)
     {
-        double d = getDistance(lat, lon, node.lat, node.lon);
-        if (d < min_dist)
+        dist.resize(n);
+        haversineMany(lat, lon, lats, lons, n, dist.data());
+        for (size_t k = 0; k < n; k++)
+            if (dist[k] < min_dist || (dist[k] == min_dist && ids[k] < nearest_id))
+            {
+                min_dist = dist[k];
+                nearest_id = ids[k];
+            }
+    };
+
+    if (gridReady())
+    {
+        // Scan rings of cells outward until nothing unscanned can be closer. Cells of a row are
+        // contiguous in cellNodes, so each row of a ring is at most two kernel calls.
+        const double R = 6371;
+        double cosQ = cos(toRadians(lat));
+        int qr = min(max(gridRow(lat), 0), grid.rows - 1);
+        int qc = min(max(gridCol(lon), 0), grid.cols - 1);
+        auto scanCells = [&](int r, int c0, int c1)
+        {
+            size_t k0 = grid.cellStart[(size_t)r * grid.cols + c0], k1 = grid.cellStart[(size_t)r * grid.cols + c1 + 1];
+            scan(&grid.cellNodes[k0], &grid.cellLat[k0], &grid.cellLon[k0], k1 - k0);
+        };
+        for (int ring = 0;; ring++)
         {
-            min_dist = d;
-            nearest_id = node.id;
+            int r0 = qr - ring, r1 = qr + ring, c0 = qc - ring, c1 = qc + ring;
+            int cLo = max(c0, 0), cHi = min(c1, grid.cols - 1);
+            for (int r = max(r0, 0); r <= min(r1, grid.rows - 1); r++)
+            {
+                if (r == r0 || r == r1)
+                    scanCells(r, cLo, cHi);
+                else
+                {
+                    if (c0 >= 0)
+                        scanCells(r, c0, c0); // interior was scanned in an earlier ring
+                    if (c1 < grid.cols && c1 != c0)
+                        scanCells(r, c1, c1);
+                }
+            }
+
+            if (r0 <= 0 && c0 <= 0 && r1 >= grid.rows - 1 && c1 >= grid.cols - 1)
+                break;
+
+            // Any unscanned node lies outside the block in lat or in lon
+            double gapLat = INF, gapLon = INF;
+            if (r0 > 0)
+                gapLat = min(gapLat, lat - (grid.minLat + r0 * grid.cellDeg));
+            if (r1 < grid.rows - 1)
+                gapLat = min(gapLat, grid.minLat + (r1 + 1) * grid.cellDeg - lat);
+            if (c0 > 0)
+                gapLon = min(gapLon, lon - (grid.minLon + c0 * grid.cellDeg));
+            if (c1 < grid.cols - 1)
+                gapLon = min(gapLon, grid.minLon + (c1 + 1) * grid.cellDeg - lon);
+
+            double bound = INF;
+            if (gapLat != INF)
+                bound = min(bound, R * toRadians(max(gapLat, 0.0)));
+            if (gapLon != INF)
+            {
+                double s = sqrt(max(cosQ * grid.minCosLat, 0.0)) * sin(toRadians(min(max(gapLon, 0.0), 180.0) / 2));
+                bound = min(bound, 2 * R * asin(min(s, 1.0)));
+            }
+            if (bound > min_dist * (1 + 1e-12 + HAV_TOLERANCE))
+                break;
         }
+        return nearest_id;
     }
+
+    vector<int> ids(nodes.size());
+    vector<double> lats(nodes.size()), lons(nodes.size());
+    for (size_t k = 0; k < nodes.size(); k++)
+        ids[k] = nodes[k].id, lats[k] = nodes[k].lat, lons[k] = nodes[k].lon;
+    scan(ids.data(), lats.data(), lons.data(), nodes.size());
     return nearest_id;
 }
 
+// New node at (lat, lon), even when one already sits there
+int createNode(double lat, double lon)
+{
+    int id = (int)nodes.size();
+    nodes.push_back({id, lat, lon, ""});
+    registerNode(id);
+    return id;
+}
+
 int getOrCreateNodeID(double lat, double lon)
 {
     int existing = getNodeID(lat, lon);
     if (existing != -1)
         return existing;
-
-    int id = (int)nodes.size();
-    nodes.push_back({id, lat, lon, ""});
-    return id;
+    return createNode(lat, lon);
 }
 
 string getEdgeTypeName(EdgeType t)
@@ -0,0 +1,204 @@
+// NodeOrder.cpp: Cache-Locality Node Renumbering
+// The loader numbers nodes in CSV encounter order, which scatters neighbouring intersections across
+// the node arrays. After buildGraph() the nodes are renumbered along a Hilbert curve over lat/lon (or in
+// BFS order) and every node-indexed array is permuted to match, so a search touches nearby memory as it
+// expands. Ids shown to users and read from traffic feeds stay the load-order ones (originalId).
+#include <bits/stdc++.h>
+using namespace std;
+
+enum NodeOrder
+{
+    ORDER_LOAD, // CSV encounter order, no renumbering
+    ORDER_HILBERT,
+    ORDER_BFS
+};
+NodeOrder nodeOrder = ORDER_LOAD; // order the current graph is numbered in
+
+const vector<string> NODE_ORDER_NAMES = {"load", "hilbert", "bfs"};
+
+string nodeOrderName(NodeOrder order) { return NODE_ORDER_NAMES[order]; }
+
+bool parseNodeOrder(const string &name, NodeOrder &out)
+{
+    for (size_t k = 0; k < NODE_ORDER_NAMES.size(); k++)
+        if (NODE_ORDER_NAMES[k] == name)
+        {
+            out = (NodeOrder)k;
+            return true;
+        }
+    return false;
+}
+
+// Section: Orders. Each returns order[new id] = current id.
+
+// Position of (x, y) along the Hilbert curve filling a 2^16 x 2^16 grid
+uint64_t hilbertIndex(uint32_t x, uint32_t y)
+{
+    const uint32_t n = 1u << 16;
+    uint64_t d = 0;
+    for (uint32_t s = n / 2; s > 0; s /= 2)
+    {
+        uint32_t rx = (x & s) > 0, ry = (y & s) > 0;
+        d += (uint64_t)s * s * ((3 * rx) ^ ry);
+        if (ry == 0)
+        {
+            if (rx == 1)
+            {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            swap(x, y);
+        }
+    }
+    return d;
+}
+
+// Nodes sorted by Hilbert index over their bounding box; lon is scaled by cos(lat) so grid cells are
+// square on the ground. Ties keep the current order.
+vector<int> hilbertOrder()
+{
+    size_t n = nodes.size();
+    vector<int> order(n);
+    iota(order.begin(), order.end(), 0);
+    if (n == 0)
+        return order;
+
+    double minLat = INF, maxLat = -INF, minLon = INF, maxLon = -INF;
+    for (const auto &node : nodes)
+    {
+        minLat = min(minLat, node.lat), maxLat = max(maxLat, node.lat);
+        minLon = min(minLon, node.lon), maxLon = max(maxLon, node.lon);
+    }
+    double cosLat = cos(toRadians((minLat + maxLat) / 2));
+    double extent = max({maxLat - minLat, (maxLon - minLon) * cosLat, 1e-9});
+    double scale = ((1 << 16) - 1) / extent;
+
+    vector<uint64_t> key(n);
+    for (size_t v = 0; v < n; v++)
+        key[v] = hilbertIndex((uint32_t)((nodes[v].lon - minLon) * cosLat * scale), (uint32_t)((nodes[v].lat - minLat) * scale));
+    stable_sort(order.begin(), order.end(), [&](int a, int b) { return key[a] < key[b]; });
+    return order;
+}
+
+// Breadth-first over the undirected graph, each component started from its lowest current id;
+// neighbours are taken in CSR order (out-edges, then in-edges)
+vector<int> bfsOrder()
+{
+    size_t n = nodes.size();
+    vector<int> order;
+    order.reserve(n);
+    vector<char> seen(n, 0);
+    for (size_t root = 0; root < n; root++)
+    {
+        if (seen[root])
+            continue;
+        seen[root] = 1;
+        order.push_back((int)root);
+        for (size_t head = order.size() - 1; head < order.size(); head++)
+        {
+            int u = order[head];
+            auto visit = [&](int v)
+            {
+                if (!seen[v])
+                {
+                    seen[v] = 1;
+                    order.push_back(v);
+                }
+            };
+            for (int e = graph.offsets[u]; e < graph.offsets[u + 1]; e++)
+                visit(graph.targets[e]);
+            for (int k = graph.in_offsets[u]; k < graph.in_offsets[u + 1]; k++)
+                visit(graph.sources[graph.in_edges[k]]);
+        }
+    }
+    return order;
+}
+
+// Section: Renumbering
+// Permute nodes and the CSR arrays to order (order[new id] = current id). Each node keeps its edges
+// in the same order, so searches relax them exactly as before; only the ids change. The derived
+// structures are rebuilt for the new ids and any traffic overrides move with their edges.
+void renumberNodes(const vector<int> &order)
+{
+    size_t n = nodes.size();
+    vector<int> rank(n);
+    for (size_t k = 0; k < n; k++)
+        rank[order[k]] = (int)k;
+
+    Graph g;
+    size_t m = graph.targets.size();
+    vector<int> oldEdge; // new edge id -> current edge id
+    oldEdge.reserve(m);
+    g.offsets.reserve(n + 1);
+    g.targets.reserve(m);
+    g.weights.reserve(m);
+    g.types.reserve(m);
+    g.geometry.reserve(m);
+    g.offsets.push_back(0);
+    for (size_t k = 0; k < n; k++)
+    {
+        int u = order[k];
+        for (int e = graph.offsets[u]; e < graph.offsets[u + 1]; e++)
+        {
+            g.targets.push_back(rank[graph.targets[e]]);
+            g.weights.push_back(graph.weights[e]);
+            g.types.push_back(graph.types[e]);
+            g.geometry.push_back(graph.geometry[e]);
+            oldEdge.push_back(e);
+        }
+        g.offsets.push_back((int)g.targets.size());
+    }
+
+    vector<Node> renumbered(n);
+    vector<int> original(n);
+    for (size_t k = 0; k < n; k++)
+    {
+        renumbered[k] = nodes[order[k]];
+        renumbered[k].id = (int)k;
+        original[k] = originalId(order[k]);
+    }
+    nodes = move(renumbered);
+    setOriginalIds(move(original));
+    graph = move(g);
+    finalizeGraph();
+
+    auto traffic = currentTraffic();
+    if (!traffic->weights.empty() || !traffic->speeds.empty())
+    {
+        auto next = make_shared<TrafficOverlay>(*traffic);
+        for (size_t e = 0; e < m; e++)
+        {
+            if (!traffic->weights.empty())
+                next->weights[e] = traffic->weights[oldEdge[e]];
+            if (!traffic->speeds.empty())
+                next->speeds[e] = traffic->speeds[oldEdge[e]];
+        }
+        publishTraffic(next);
+    }
+
+    // Node-indexed lookups built so far follow the new ids
+    bool indexed = dedupReady();
+    dedupHead.clear();
+    dedupNext.clear();
+    if (indexed)
+        for (size_t k = 0; k < n; k++)
+            registerNode((int)k);
+    if (gridReady())
+        buildSpatialIndex();
+}
+
+void renumberNodes(NodeOrder order)
+{
+    if (order == ORDER_HILBERT)
+        renumberNodes(hilbertOrder());
+    else if (order == ORDER_BFS)
+        renumberNodes(bfsOrder());
+    else if (!sourceId.empty())
+    {
+        renumberNodes(vector<int>(sourceNode)); // back to load order
+        setOriginalIds({});
+    }
+    else if (!graphDerived)
+        finalizeGraph(); // buildGraph(false) left it to the renumbering, which turned out to be a no-op
+    nodeOrder = order;
+}
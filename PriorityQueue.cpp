@@ -0,0 +1,174 @@
+// PriorityQueue.cpp: Search Queues
+// Node-keyed min-queues for the solvers, which take one as a template parameter. Each offers
+// clear(), empty(), push(key, v) to insert v or lower its key, minKey() and pop() -> (key, v).
+// Solvers keep their stale-entry check, so a queue that never holds stale entries never trips it.
+#include <bits/stdc++.h>
+using namespace std;
+
+// Binary heap with lazy deletion: lowering a key pushes a duplicate and the old entry pops as stale
+struct LazyHeap
+{
+    priority_queue<pair<double, int>, vector<pair<double, int>>, greater<pair<double, int>>> heap;
+
+    void clear() { heap = decltype(heap)(); }
+    bool empty() const { return heap.empty(); }
+    void push(double key, int v) { heap.push({key, v}); }
+    double minKey() const { return heap.top().first; }
+    pair<double, int> pop()
+    {
+        auto top = heap.top();
+        heap.pop();
+        return top;
+    }
+};
+
+// Indexed 4-ary heap with decrease-key: one entry per node, never a stale pop. Children of slot i
+// are 4i+1 .. 4i+4, which keeps sift-down to one cache line of keys per level.
+struct QuadHeap
+{
+    vector<pair<double, int>> heap;
+    vector<int> pos; // node -> slot in heap, -1 when not queued
+
+    void clear()
+    {
+        if (pos.size() != nodes.size())
+            pos.assign(nodes.size(), -1);
+        for (const auto &[k, v] : heap)
+            pos[v] = -1;
+        heap.clear();
+    }
+    bool empty() const { return heap.empty(); }
+    double minKey() const { return heap[0].first; }
+
+    void push(double key, int v)
+    {
+        int i = pos[v];
+        if (i == -1)
+        {
+            i = (int)heap.size();
+            heap.push_back({key, v});
+        }
+        else if (key >= heap[i].first)
+            return;
+        siftUp(i, {key, v});
+    }
+
+    pair<double, int> pop()
+    {
+        auto top = heap[0];
+        pos[top.second] = -1;
+        auto last = heap.back();
+        heap.pop_back();
+        if (!heap.empty())
+            siftDown(0, last);
+        return top;
+    }
+
+    void siftUp(int i, pair<double, int> item)
+    {
+        while (i > 0)
+        {
+            int parent = (i - 1) / 4;
+            if (heap[parent].first <= item.first)
+                break;
+            place(i, heap[parent]);
+            i = parent;
+        }
+        place(i, item);
+    }
+
+    void siftDown(int i, pair<double, int> item)
+    {
+        int n = (int)heap.size();
+        while (true)
+        {
+            int first = 4 * i + 1;
+            if (first >= n)
+                break;
+            int best = first;
+            for (int c = first + 1; c < min(first + 4, n); c++)
+                if (heap[c].first < heap[best].first)
+                    best = c;
+            if (heap[best].first >= item.first)
+                break;
+            place(i, heap[best]);
+            i = best;
+        }
+        place(i, item);
+    }
+
+    void place(int i, pair<double, int> item)
+    {
+        heap[i] = item;
+        pos[item.second] = i;
+    }
+};
+
+// Radix heap over keys scaled to integers (floor(key * scale)). Keys must be monotone: nothing below
+// the last popped key may be pushed, which Dijkstra and consistent A* guarantee; float drift just
+// below it is clamped. Keys equal after scaling pop in any order, so a node may be settled up to
+// 1/scale above its best label; the solver then lowers and re-queues it like a lazy duplicate.
+struct RadixHeap
+{
+    struct Entry
+    {
+        uint64_t scaled;
+        double key;
+        int v;
+    };
+    double scale;
+    uint64_t last = 0;
+    size_t count = 0;
+    array<vector<Entry>, 65> buckets; // bucket b holds keys whose highest bit differing from last is b - 1
+
+    explicit RadixHeap(double scale = 1e6) : scale(scale) {}
+
+    void clear()
+    {
+        for (auto &b : buckets)
+            b.clear();
+        last = 0;
+        count = 0;
+    }
+    bool empty() const { return count == 0; }
+    int bucketOf(uint64_t scaled) const { return scaled == last ? 0 : 64 - __builtin_clzll(scaled ^ last); }
+
+    void push(double key, int v)
+    {
+        uint64_t scaled = max(last, (uint64_t)(key * scale));
+        buckets[bucketOf(scaled)].push_back({scaled, key, v});
+        count++;
+    }
+
+    // Refill bucket 0 from the lowest non-empty bucket, whose minimum becomes the new last
+    void settleMin()
+    {
+        if (!buckets[0].empty())
+            return;
+        int b = 1;
+        while (buckets[b].empty())
+            b++;
+        last = UINT64_MAX;
+        for (const auto &x : buckets[b])
+            last = min(last, x.scaled);
+        for (const auto &x : buckets[b])
+            buckets[bucketOf(x.scaled)].push_back(x);
+        buckets[b].clear();
+    }
+
+    // Lower bound on the smallest key (exact up to 1/scale)
+    double minKey()
+    {
+        settleMin();
+        return last / scale;
+    }
+
+    pair<double, int> pop()
+    {
+        settleMin();
+        Entry x = buckets[0].back();
+        buckets[0].pop_back();
+        count--;
+        return {x.key, x.v};
+    }
+};
@@ -0,0 +1,658 @@
+// Raptor.cpp: Round-Based Public Transit Routing (McRAPTOR)
+// Metro and bus lines are scanned route by route, one round per ride, so every journey found in round k
+// uses exactly k vehicles. Labels are Pareto-optimal in (arrival time, fare) per round, which makes the
+// result Pareto-optimal in (arrival, transfers, fare). The road graph is only walked for access, egress
+// and transfers between nearby stops.
+#include <bits/stdc++.h>
+using namespace std;
+
+// Transit Network: lines recovered from the METRO / BUS edges loaded from the Routemap CSVs
+struct TransitRoute
+{
+    EdgeType type;
+    vector<int> stops;     // node ids in travel order
+    vector<int> seg_edges; // graph edge from stops[i] to stops[i + 1]
+};
+
+struct Footpath
+{
+    int to_stop;       // index into TransitNetwork::stops
+    double km;
+    vector<int> edges; // walking path over the road graph
+};
+
+struct TransitNetwork
+{
+    vector<int> stops;                 // stop index -> node id
+    unordered_map<int, int> stopIndex; // node id -> stop index
+    vector<TransitRoute> routes;
+    vector<vector<pair<int, int>>> routesAt; // stop index -> (route, position in route)
+    vector<vector<Footpath>> transfers;      // stop index -> walks to other stops
+};
+
+bool isTransitType(EdgeType t) { return t == METRO || t == BUS_BIKOLPO || t == BUS_UTTARA; }
+
+// Walkable part of the road graph: streets and station links
+const unsigned WALK_MASK = (1u << ROAD) | (1u << WALKING);
+const double MAX_TRANSFER_KM = 1.0;
+
+// Bounded walking search from src (or towards it when reverse) over physical km, avoiding edges closed
+// by live traffic; fills ws and returns reached nodes
+vector<int> walkSearch(SearchWorkspace &ws, int src, double maxKm, bool reverse)
+{
+    vector<int> reached;
+    auto traffic = currentTraffic();
+    priority_queue<pair<double, int>, vector<pair<double, int>>, greater<pair<double, int>>> pq;
+    ws.begin();
+    ws.set(src, 0, -1);
+    pq.push({0, src});
+    const vector<int> &offsets = reverse ? graph.in_offsets : graph.offsets;
+    while (!pq.empty())
+    {
+        auto [d, u] = pq.top();
+        pq.pop();
+        if (d > ws.dist[u])
+            continue;
+        reached.push_back(u);
+        for (int k = offsets[u]; k < offsets[u + 1]; k++)
+        {
+            int e = reverse ? graph.in_edges[k] : k;
+            if (!(WALK_MASK >> graph.types[e] & 1) || traffic->closed(e))
+                continue;
+            int v = reverse ? graph.sources[e] : graph.targets[e];
+            double nd = d + graph.weights[e];
+            if (nd <= maxKm && nd < ws.distOf(v))
+            {
+                ws.set(v, nd, e);
+                pq.push({nd, v});
+            }
+        }
+    }
+    return reached;
+}
+
+// Edge ids of the walk ending at v (forward search) or starting at v (reverse search)
+vector<int> walkEdges(const SearchWorkspace &ws, int v, bool reverse)
+{
+    vector<int> edges;
+    for (int e = ws.parent_edge[v]; e != -1; e = ws.parent_edge[reverse ? graph.targets[e] : graph.sources[e]])
+        edges.push_back(e);
+    if (!reverse)
+        std::reverse(edges.begin(), edges.end());
+    return edges;
+}
+
+// Each Routemap type forms a set of station-to-station segments; maximal chains through
+// degree-2 stations become lines, and every line is served in both directions
+void buildTransitRoutes(TransitNetwork &net)
+{
+    for (EdgeType type : {METRO, BUS_BIKOLPO, BUS_UTTARA})
+    {
+        map<int, vector<int>> segs; // node -> outgoing edges of this type
+        for (size_t e = 0; e < graph.targets.size(); e++)
+            if (graph.types[e] == type && graph.sources[e] != graph.targets[e])
+                segs[graph.sources[e]].push_back((int)e);
+
+        auto degree = [&](int v)
+        {
+            set<int> nb;
+            for (int e : segs[v])
+                nb.insert(graph.targets[e]);
+            return nb.size();
+        };
+
+        set<pair<int, int>> used; // undirected station pairs already on a line
+        auto walkLine = [&](int from, int first)
+        {
+            TransitRoute r{type, {from}, {}};
+            int e = first;
+            while (true)
+            {
+                int u = graph.sources[e], v = graph.targets[e];
+                used.insert({min(u, v), max(u, v)});
+                r.stops.push_back(v);
+                r.seg_edges.push_back(e);
+                if (degree(v) != 2 || v == from)
+                    break;
+                int next = -1;
+                for (int f : segs[v])
+                    if (!used.count({min(v, graph.targets[f]), max(v, graph.targets[f])}))
+                        next = f;
+                if (next == -1)
+                    break;
+                e = next;
+            }
+            return r;
+        };
+
+        // Chains start at line ends and junctions; anything left over is a loop
+        vector<TransitRoute> lines;
+        for (int pass = 0; pass < 2; pass++)
+            for (auto &[u, out] : segs)
+            {
+                if (pass == 0 && degree(u) == 2)
+                    continue;
+                for (int e : out)
+                {
+                    int v = graph.targets[e];
+                    if (!used.count({min(u, v), max(u, v)}))
+                        lines.push_back(walkLine(u, e));
+                }
+            }
+
+        // Reverse direction: follow the paired edge of each segment
+        for (auto &line : lines)
+        {
+            TransitRoute back{type, {line.stops.rbegin(), line.stops.rend()}, {}};
+            for (size_t i = 0; i + 1 < back.stops.size(); i++)
+            {
+                int u = back.stops[i], v = back.stops[i + 1], pick = -1;
+                for (int e : segs[u])
+                    if (graph.targets[e] == v && (pick == -1 || graph.weights[e] < graph.weights[pick]))
+                        pick = e;
+                if (pick == -1)
+                {
+                    back.stops.clear(); // one-way segment: no return service
+                    break;
+                }
+                back.seg_edges.push_back(pick);
+            }
+            net.routes.push_back(move(line));
+            if (!back.stops.empty())
+                net.routes.push_back(move(back));
+        }
+    }
+}
+
+TransitNetwork buildTransitNetwork()
+{
+    TransitNetwork net;
+    buildTransitRoutes(net);
+
+    for (size_t r = 0; r < net.routes.size(); r++)
+        for (size_t i = 0; i < net.routes[r].stops.size(); i++)
+        {
+            int node = net.routes[r].stops[i];
+            auto it = net.stopIndex.emplace(node, (int)net.stops.size());
+            if (it.second)
+            {
+                net.stops.push_back(node);
+                net.routesAt.emplace_back();
+            }
+            net.routesAt[it.first->second].push_back({(int)r, (int)i});
+        }
+
+    // Transfers: walk the road graph from every stop to the stops within MAX_TRANSFER_KM
+    net.transfers.resize(net.stops.size());
+    SearchWorkspace ws;
+    for (size_t s = 0; s < net.stops.size(); s++)
+        for (int v : walkSearch(ws, net.stops[s], MAX_TRANSFER_KM, false))
+        {
+            auto it = net.stopIndex.find(v);
+            if (it != net.stopIndex.end() && it->second != (int)s)
+                net.transfers[s].push_back({it->second, ws.dist[v], walkEdges(ws, v, false)});
+        }
+    return net;
+}
+
+// Built on first use; clearGraphCaches() drops it with the other caches that hold node ids, and each
+// traffic update drops it so the transfers avoid newly closed edges. Searches keep the pointer they
+// started with.
+shared_ptr<const TransitNetwork> transitNet;
+mutex transitMutex;
+
+shared_ptr<const TransitNetwork> transitNetwork()
+{
+    lock_guard<mutex> lock(transitMutex);
+    if (!transitNet)
+        transitNet = make_shared<const TransitNetwork>(buildTransitNetwork());
+    return transitNet;
+}
+
+void clearTransitNetwork()
+{
+    lock_guard<mutex> lock(transitMutex);
+    transitNet.reset();
+}
+
+// Stops within maxKm walking of src (or towards it when reverse) as (stop index, km); ws keeps the walks.
+// With no stop in range the radius grows to the nearest stop's walk plus maxKm, so an origin or
+// destination away from every line is still served. Returns the radius used.
+double walkToStops(const TransitNetwork &net, SearchWorkspace &ws, int src, double maxKm, bool reverse,
+                   vector<pair<int, double>> &stops)
+{
+    auto isStop = [&](int v) { return net.stopIndex.count(v) > 0; };
+    double radius = maxKm;
+    vector<int> reached = walkSearch(ws, src, radius, reverse);
+    if (none_of(reached.begin(), reached.end(), isStop))
+    {
+        reached = walkSearch(ws, src, INF, reverse);
+        auto nearest = find_if(reached.begin(), reached.end(), isStop); // settled in walk order
+        if (nearest != reached.end())
+            radius = ws.dist[*nearest] + maxKm;
+    }
+    for (int v : reached)
+        if (ws.dist[v] <= radius && isStop(v))
+            stops.push_back({net.stopIndex.at(v), ws.dist[v]});
+    return radius;
+}
+
+// Query
+struct RaptorParams
+{
+    map<EdgeType, double> rates, speeds; // fares per km; vehicle speeds (km/h)
+    int pid = 6;                         // schedule set passed to getWaitingTime
+    double walk_speed = 2.0;             // km/h
+    double max_walk_km = 2.0;            // access / egress radius (widened when no stop is in range)
+    int max_rounds = 5;                  // rides per journey
+};
+
+struct JourneyLeg
+{
+    EdgeType mode; // WALKING or the transit type ridden
+    int from, to;  // node ids
+    double depart, arrive, fare, km;
+    vector<int> edge_ids;
+};
+
+struct Journey
+{
+    double depart, arrival, fare;
+    int rides;
+    vector<JourneyLeg> legs;
+};
+
+// Search state for one origin/destination pair. Labels persist across run() calls, so running
+// departures latest-first (range RAPTOR) only propagates what an earlier departure improves.
+struct RaptorSearch
+{
+    enum Kind
+    {
+        ACCESS,
+        RIDE,
+        TRANSFER,
+        EGRESS
+    };
+    struct Label
+    {
+        double dep, arr, fare; // dep: departure from the origin
+        int kind, stop, prev;  // stop index (-1 for the destination); prev label
+        int route, board, alight, footpath;
+        int rides;
+    };
+
+    shared_ptr<const TransitNetwork> network;
+    const TransitNetwork &net;
+    const RaptorParams &params;
+    int start, end;
+    array<double, EDGE_TYPE_COUNT> rate, speed;
+    SearchWorkspace &access, &egress;
+    vector<pair<int, double>> accessStops; // (stop index, walk km)
+    vector<double> egressKm;               // stop index -> walk km to the destination
+    double directKm;                       // walk-only journey, INF when out of range
+
+    vector<Label> labels;              // arena; bags hold indices
+    vector<int> destination;           // Pareto in (arrival, rides, fare)
+    vector<vector<vector<int>>> best;  // best[k][stop]: Pareto in (arrival, fare) over journeys with <= k rides
+    vector<vector<int>> prevBag, curBag;
+    vector<char> marked;
+
+    RaptorSearch(int start, int end, const RaptorParams &params)
+        : network(transitNetwork()), net(*network), params(params), start(start), end(end), rate(typeTable(params.rates)),
+          speed(typeTable(params.speeds)), access(threadWorkspace(0)), egress(threadWorkspace(1))
+    {
+        size_t nStops = net.stops.size();
+        double accessRadius = walkToStops(net, access, start, params.max_walk_km, false, accessStops);
+        vector<pair<int, double>> egressStops;
+        walkToStops(net, egress, end, params.max_walk_km, true, egressStops);
+        egressKm.assign(nStops, INF);
+        for (auto [s, km] : egressStops)
+            egressKm[s] = km;
+        directKm = access.distOf(end) <= accessRadius ? access.dist[end] : INF;
+        best.assign(params.max_rounds + 1, vector<vector<int>>(nStops));
+        prevBag.resize(nStops);
+        curBag.resize(nStops);
+        marked.assign(nStops, 0);
+    }
+
+    bool dominates(int a, double arr, double fare) const
+    {
+        return labels[a].arr <= arr + 1e-12 && labels[a].fare <= fare + 1e-12;
+    }
+
+    void addDestination(const Label &l)
+    {
+        for (int d : destination)
+            if (labels[d].rides <= l.rides && dominates(d, l.arr, l.fare))
+                return;
+        destination.erase(remove_if(destination.begin(), destination.end(), [&](int d)
+                                    { return labels[d].rides >= l.rides && labels[d].arr >= l.arr && labels[d].fare >= l.fare; }),
+                          destination.end());
+        labels.push_back(l);
+        destination.push_back((int)labels.size() - 1);
+    }
+
+    // Stop labels: rejected when a journey with no more rides already did at least as well (or the target did)
+    bool addStopLabel(const Label &l)
+    {
+        for (int d : destination)
+            if (labels[d].rides <= l.rides && dominates(d, l.arr, l.fare))
+                return false;
+        for (int b : best[l.rides][l.stop])
+            if (dominates(b, l.arr, l.fare))
+                return false;
+        auto worse = [&](int b)
+        { return labels[b].arr >= l.arr && labels[b].fare >= l.fare; };
+        labels.push_back(l);
+        int id = (int)labels.size() - 1;
+        for (int k = l.rides; k <= params.max_rounds; k++)
+        {
+            vector<int> &bag = best[k][l.stop];
+            bag.erase(remove_if(bag.begin(), bag.end(), worse), bag.end());
+            bag.push_back(id);
+        }
+        curBag[l.stop].erase(remove_if(curBag[l.stop].begin(), curBag[l.stop].end(), worse), curBag[l.stop].end());
+        curBag[l.stop].push_back(id);
+        return true;
+    }
+
+    // One McRAPTOR pass for a departure at start_time
+    void run(double start_time)
+    {
+        size_t nStops = net.stops.size();
+        for (auto &bag : curBag)
+            bag.clear();
+        fill(marked.begin(), marked.end(), 0);
+
+        if (directKm < INF)
+            addDestination({start_time, start_time + directKm / params.walk_speed, 0, EGRESS, -1, -1, -1, -1, -1, -1, 0});
+        for (auto [s, km] : accessStops)
+            if (addStopLabel({start_time, start_time + km / params.walk_speed, 0, ACCESS, s, -1, -1, -1, -1, -1, 0}))
+                marked[s] = 1;
+
+        for (int round = 1; round <= params.max_rounds; round++)
+        {
+            swap(prevBag, curBag);
+            for (auto &bag : curBag)
+                bag.clear();
+
+            // Routes touching a stop improved last round, scanned from the earliest such stop
+            map<int, int> queue;
+            for (size_t s = 0; s < nStops; s++)
+                if (marked[s])
+                    for (auto [r, pos] : net.routesAt[s])
+                    {
+                        auto it = queue.find(r);
+                        if (it == queue.end() || pos < it->second)
+                            queue[r] = pos;
+                    }
+            fill(marked.begin(), marked.end(), 0);
+
+            for (auto [r, from] : queue)
+            {
+                const TransitRoute &route = net.routes[r];
+                struct Ride
+                {
+                    double arr, fare; // on the vehicle, at the current stop
+                    int board, prev;
+                };
+                vector<Ride> bag;
+                for (int i = from; i < (int)route.stops.size(); i++)
+                {
+                    int s = net.stopIndex.at(route.stops[i]);
+                    if (i > from)
+                    {
+                        int e = route.seg_edges[i - 1];
+                        double travel = speed[route.type] > 0 ? graph.weights[e] / speed[route.type] : 0;
+                        for (auto &ride : bag)
+                        {
+                            ride.arr += travel;
+                            ride.fare += graph.weights[e] * rate[route.type];
+                        }
+                        for (auto &ride : bag)
+                            if (addStopLabel({labels[ride.prev].dep, ride.arr, ride.fare, RIDE, s, ride.prev, r, ride.board, i,
+                                              -1, round}))
+                                marked[s] = 1;
+                    }
+
+                    // Board here from last round's labels: wait for the next departure of this line
+                    for (int l : prevBag[s])
+                    {
+                        double wait = getWaitingTime(labels[l].arr, route.type, params.pid);
+                        if (wait == INF)
+                            continue;
+                        Ride ride{labels[l].arr + wait, labels[l].fare, i, l};
+                        bool dominated = false;
+                        for (auto &o : bag)
+                            dominated |= o.arr <= ride.arr && o.fare <= ride.fare;
+                        if (dominated)
+                            continue;
+                        bag.erase(remove_if(bag.begin(), bag.end(), [&](const Ride &o)
+                                            { return o.arr >= ride.arr && o.fare >= ride.fare; }),
+                                  bag.end());
+                        bag.push_back(ride);
+                    }
+                }
+            }
+
+            // Transfers: one walk from each stop reached by a ride this round
+            vector<int> rideLabels;
+            for (size_t s = 0; s < nStops; s++)
+                if (marked[s])
+                    rideLabels.insert(rideLabels.end(), curBag[s].begin(), curBag[s].end());
+            for (int l : rideLabels)
+            {
+                int s = labels[l].stop;
+                for (size_t f = 0; f < net.transfers[s].size(); f++)
+                {
+                    const Footpath &fp = net.transfers[s][f];
+                    if (addStopLabel({labels[l].dep, labels[l].arr + fp.km / params.walk_speed, labels[l].fare, TRANSFER,
+                                      fp.to_stop, l, -1, -1, -1, (int)f, round}))
+                        marked[fp.to_stop] = 1;
+                }
+            }
+
+            // Egress: walk from any improved stop to the destination
+            bool any = false;
+            for (size_t s = 0; s < nStops; s++)
+            {
+                if (!marked[s])
+                    continue;
+                any = true;
+                if (egressKm[s] == INF)
+                    continue;
+                for (int l : vector<int>(curBag[s]))
+                    addDestination({labels[l].dep, labels[l].arr + egressKm[s] / params.walk_speed, labels[l].fare, EGRESS,
+                                    -1, l, -1, -1, -1, -1, round});
+            }
+            if (!any)
+                break;
+        }
+    }
+
+    // Unwind the current destination labels into legs
+    vector<Journey> journeys() const
+    {
+        vector<Journey> result;
+        for (int d : destination)
+        {
+            Journey j{labels[d].dep, labels[d].arr, labels[d].fare, labels[d].rides, {}};
+            for (int l = d; l != -1; l = labels[l].prev)
+            {
+                const Label &cur = labels[l];
+                const Label *prev = cur.prev == -1 ? nullptr : &labels[cur.prev];
+                double depart = prev ? prev->arr : cur.dep;
+                int fromNode = prev ? net.stops[prev->stop] : start;
+                int toNode = cur.stop == -1 ? end : net.stops[cur.stop];
+                JourneyLeg leg{WALKING, fromNode, toNode, depart, cur.arr, cur.fare - (prev ? prev->fare : 0), 0, {}};
+                if (cur.kind == RIDE)
+                {
+                    const TransitRoute &route = net.routes[cur.route];
+                    leg.mode = route.type;
+                    leg.edge_ids.assign(route.seg_edges.begin() + cur.board, route.seg_edges.begin() + cur.alight);
+                }
+                else if (cur.kind == TRANSFER)
+                    leg.edge_ids = net.transfers[prev->stop][cur.footpath].edges;
+                else if (cur.kind == ACCESS || (cur.kind == EGRESS && !prev))
+                    leg.edge_ids = walkEdges(access, toNode, false);
+                else
+                    leg.edge_ids = walkEdges(egress, fromNode, true);
+                for (int e : leg.edge_ids)
+                    leg.km += graph.weights[e];
+                j.legs.push_back(move(leg));
+            }
+            reverse(j.legs.begin(), j.legs.end());
+            result.push_back(move(j));
+        }
+        sort(result.begin(), result.end(), [](const Journey &a, const Journey &b)
+             { return tie(a.rides, a.arrival, a.fare) < tie(b.rides, b.arrival, b.fare); });
+        return result;
+    }
+};
+
+vector<Journey> raptorQuery(int start, int end, double start_time, const RaptorParams &params)
+{
+    RaptorSearch search(start, end, params);
+    search.run(start_time);
+    return search.journeys();
+}
+
+// Departure-Time Profile
+// Every departure in (from, to] is served by the journeys that leave at `to`: waiting at the origin costs
+// nothing, and no vehicle can be caught in between.
+struct ProfileSegment
+{
+    double from, to;
+    vector<Journey> journeys; // Pareto set for a departure at `to`
+};
+
+// Range RAPTOR over [window_start, window_end]. Only departures that catch a vehicle exactly matter;
+// they follow from the periodic schedules, so one pass per departure event (latest first, labels kept)
+// replaces a point query per minute. Consecutive departures with the same Pareto set are merged.
+vector<ProfileSegment> raptorProfile(int start, int end, double window_start, double window_end, const RaptorParams &params)
+{
+    RaptorSearch search(start, end, params);
+
+    // Departure events: for every access stop and line type there, the scheduled departures reachable in the window
+    vector<double> departures = {window_end};
+    for (auto [s, km] : search.accessStops)
+    {
+        double walk = km / params.walk_speed;
+        set<EdgeType> types;
+        for (auto [r, pos] : search.net.routesAt[s])
+            types.insert(search.net.routes[r].type);
+        for (EdgeType type : types)
+        {
+            // Walk the schedule through getWaitingTime so the events match what boarding sees
+            double t = window_start + walk;
+            for (double wait; t <= window_end + walk && (wait = getWaitingTime(t, type, params.pid)) != INF;)
+            {
+                t += wait;
+                if (t - walk > window_end + 1e-9)
+                    break;
+                departures.push_back(t - walk);
+                t += 1.0 / 3600; // next departure after this one
+            }
+        }
+    }
+    sort(departures.rbegin(), departures.rend());
+
+    vector<ProfileSegment> profile; // built latest first
+    double prevDep = INF;
+    for (double dep : departures)
+    {
+        if (prevDep - dep < 1e-9)
+            continue;
+        prevDep = dep;
+        search.run(dep);
+        vector<Journey> js = search.journeys();
+        auto sameAs = [&](const vector<Journey> &other)
+        {
+            if (other.size() != js.size())
+                return false;
+            for (size_t i = 0; i < js.size(); i++)
+                if (abs(other[i].depart - js[i].depart) > 1e-9 || abs(other[i].arrival - js[i].arrival) > 1e-9 ||
+                    abs(other[i].fare - js[i].fare) > 1e-9 || other[i].rides != js[i].rides)
+                    return false;
+            return true;
+        };
+        bool same = !profile.empty() && sameAs(profile.back().journeys);
+        if (!profile.empty())
+            profile.back().from = dep;
+        if (!same)
+            profile.push_back({dep, dep, move(js)});
+    }
+    if (!profile.empty())
+        profile.back().from = window_start;
+    reverse(profile.begin(), profile.end());
+    return profile;
+}
+
+// Journey as a SolutionPath (walks show up as their road/link edges) for exportKML
+SolutionPath journeyPath(const Journey &j, int start)
+{
+    vector<int> edges;
+    for (const auto &leg : j.legs)
+        edges.insert(edges.end(), leg.edge_ids.begin(), leg.edge_ids.end());
+    SolutionPath path = pathFromEdges(start, edges, {});
+    path.total_cost = j.fare;
+    path.total_time = j.arrival - j.depart;
+    return path;
+}
+
+void printJourneys(const vector<Journey> &journeys)
+{
+    if (journeys.empty())
+    {
+        cout << "No journey found." << endl;
+        return;
+    }
+    for (size_t i = 0; i < journeys.size(); i++)
+    {
+        const Journey &j = journeys[i];
+        cout << "Journey " << i + 1 << ": " << formatTime(j.depart) << " - " << formatTime(j.arrival)
+             << ", Fare: " << fixed << setprecision(2) << j.fare << " Tk, Transfers: " << max(0, j.rides - 1) << endl;
+        for (const auto &leg : j.legs)
+        {
+            if (leg.from == leg.to && leg.mode == WALKING)
+                continue;
+            string from = nodes[leg.from].name.empty() ? "RoadIntersection" : string(nodes[leg.from].name);
+            string to = nodes[leg.to].name.empty() ? "RoadIntersection" : string(nodes[leg.to].name);
+            cout << "  " << formatTime(leg.depart) << " - " << formatTime(leg.arrive) << ": "
+                 << (leg.mode == WALKING ? "Walk" : "Ride " + getEdgeTypeName(leg.mode)) << " (" << leg.km << " km) from "
+                 << from << " to " << to << ", Cost: " << leg.fare << " Tk" << endl;
+        }
+    }
+    cout << endl;
+}
+
+// One line per profile segment: the arrival-time and fare functions over the departure window
+void printProfile(const vector<ProfileSegment> &profile)
+{
+    if (profile.empty())
+    {
+        cout << "No departures in window." << endl;
+        return;
+    }
+    for (const auto &seg : profile)
+    {
+        cout << formatTime(seg.from) << " - " << formatTime(seg.to) << ": ";
+        if (seg.journeys.empty())
+        {
+            cout << "no journey" << endl;
+            continue;
+        }
+        const Journey *fastest = &seg.journeys[0], *cheapest = &seg.journeys[0];
+        for (const auto &j : seg.journeys)
+        {
+            if (tie(j.arrival, j.fare) < tie(fastest->arrival, fastest->fare))
+                fastest = &j;
+            if (tie(j.fare, j.arrival) < tie(cheapest->fare, cheapest->arrival))
+                cheapest = &j;
+        }
+        cout << "Leave " << formatTime(fastest->depart) << ", Earliest Arrival: " << formatTime(fastest->arrival)
+             << " (" << fixed << setprecision(2) << fastest->fare << " Tk), Cheapest: " << cheapest->fare << " Tk (arrive "
+             << formatTime(cheapest->arrival) << "), Options: " << seg.journeys.size() << endl;
+    }
+    cout << endl;
+}
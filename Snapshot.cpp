@@ -0,0 +1,244 @@
+// Snapshot.cpp: Binary Graph Snapshot
+// Caches the frozen graph (nodes, names, CSR edges, types, geometry pool) so later runs skip the CSVs.
+// The snapshot records the size and mtime of every source file and the node order, and is rebuilt when
+// any of them changes.
+#include <bits/stdc++.h>
+using namespace std;
+
+// Bump whenever loading or linking changes what ends up in the graph
+const uint32_t SNAPSHOT_VERSION = 5;
+const char SNAPSHOT_MAGIC[8] = {'D', 'H', 'K', 'G', 'R', 'A', 'P', 'H'};
+
+struct SourceStamp
+{
+    uint64_t size;
+    int64_t mtime_ns;
+};
+
+bool stampFile(const string &path, SourceStamp &out)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return false;
+    out.size = st.st_size;
+    out.mtime_ns = (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    return true;
+}
+
+// Writer: every section is padded to 8 bytes so arrays stay aligned inside the mapping
+struct SnapshotWriter
+{
+    ofstream out;
+    uint64_t pos = 0;
+
+    void bytes(const void *p, size_t n)
+    {
+        out.write((const char *)p, n);
+        pos += n;
+    }
+    template <typename T>
+    void value(const T &v) { bytes(&v, sizeof(T)); }
+    template <typename T>
+    void array(const vector<T> &v)
+    {
+        value<uint64_t>(v.size());
+        bytes(v.data(), v.size() * sizeof(T));
+        align();
+    }
+    void align()
+    {
+        static const char zeros[8] = {};
+        if (pos % 8)
+            bytes(zeros, 8 - pos % 8);
+    }
+};
+
+// Reader: bounds-checked cursor over the mapped file
+struct SnapshotReader
+{
+    const char *data;
+    size_t size, pos = 0;
+    bool ok = true;
+
+    const char *take(size_t n)
+    {
+        if (!ok || n > size - pos)
+        {
+            ok = false;
+            return nullptr;
+        }
+        const char *p = data + pos;
+        pos += n;
+        return p;
+    }
+    template <typename T>
+    T value()
+    {
+        T v{};
+        if (const char *p = take(sizeof(T)))
+            memcpy(&v, p, sizeof(T));
+        return v;
+    }
+    template <typename T>
+    void array(vector<T> &v)
+    {
+        uint64_t n = value<uint64_t>();
+        if (!ok || n > (size - pos) / sizeof(T))
+        {
+            ok = false;
+            return;
+        }
+        v.resize(n);
+        memcpy(v.data(), take(n * sizeof(T)), n * sizeof(T));
+        align();
+    }
+    void align()
+    {
+        if (pos % 8)
+            take(8 - pos % 8);
+    }
+};
+
+bool saveSnapshot(const string &filename, const vector<string> &sources)
+{
+    string tmp = filename + ".tmp";
+    SnapshotWriter w;
+    w.out.open(tmp, ios::binary | ios::trunc);
+    if (!w.out)
+        return false;
+
+    w.bytes(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    w.value<uint32_t>(SNAPSHOT_VERSION);
+    w.value<uint32_t>(sources.size());
+    for (const auto &src : sources)
+    {
+        SourceStamp st;
+        if (!stampFile(src, st))
+        {
+            w.out.close();
+            remove(tmp.c_str());
+            return false;
+        }
+        w.value(st);
+        w.value<uint32_t>(src.size());
+        w.bytes(src.data(), src.size());
+        w.align();
+    }
+    w.value<uint32_t>(nodeOrder);
+    w.align();
+
+    // Nodes: coordinates plus a name blob addressed by offsets
+    vector<Point> coords;
+    vector<uint32_t> nameOffsets = {0};
+    vector<char> nameBlob;
+    coords.reserve(nodes.size());
+    for (const auto &n : nodes)
+    {
+        coords.push_back({n.lat, n.lon});
+        nameBlob.insert(nameBlob.end(), n.name.begin(), n.name.end());
+        nameOffsets.push_back(nameBlob.size());
+    }
+    w.array(coords);
+    w.array(nameOffsets);
+    w.array(nameBlob);
+    w.array(sourceId);
+
+    // Edges: CSR arrays, then per-edge references into the geometry pool and the pool itself
+    w.array(graph.offsets);
+    w.array(graph.targets);
+    w.array(graph.weights);
+    w.array(graph.types);
+    w.array(graph.geometry);
+    w.array(geometryPool);
+
+    w.out.close();
+    if (!w.out || rename(tmp.c_str(), filename.c_str()) != 0)
+    {
+        remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Returns false (leaving the graph untouched) if the snapshot is missing, corrupt, from another version,
+// stale or numbered in another node order
+bool loadSnapshot(const string &filename, const vector<string> &sources, NodeOrder order)
+{
+    MappedFile file(filename);
+    if (!file.data)
+        return false;
+    SnapshotReader r{file.data, file.size};
+
+    const char *magic = r.take(sizeof(SNAPSHOT_MAGIC));
+    if (!magic || memcmp(magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0)
+        return false;
+    if (r.value<uint32_t>() != SNAPSHOT_VERSION || r.value<uint32_t>() != sources.size())
+        return false;
+    for (const auto &src : sources)
+    {
+        SourceStamp saved = r.value<SourceStamp>(), now;
+        uint32_t len = r.value<uint32_t>();
+        const char *path = r.take(len);
+        r.align();
+        if (!r.ok || !stampFile(src, now) || string(path, len) != src ||
+            saved.size != now.size || saved.mtime_ns != now.mtime_ns)
+            return false;
+    }
+    if (r.value<uint32_t>() != (uint32_t)order)
+        return false;
+    r.align();
+
+    vector<Point> coords;
+    vector<uint32_t> nameOffsets;
+    vector<char> nameBlob;
+    vector<int> ids;
+    r.array(coords);
+    r.array(nameOffsets);
+    r.array(nameBlob);
+    r.array(ids);
+
+    Graph g;
+    vector<FixedPoint> pool;
+    r.array(g.offsets);
+    r.array(g.targets);
+    r.array(g.weights);
+    r.array(g.types);
+    r.array(g.geometry);
+    r.array(pool);
+    if (!r.ok)
+        return false;
+
+    // Structural checks before anything indexes with these arrays
+    size_t n = coords.size(), m = g.targets.size();
+    if (nameOffsets.size() != n + 1 || nameOffsets.back() != nameBlob.size() || g.offsets.size() != n + 1 || g.offsets[0] != 0 ||
+        g.offsets.back() != (int)m || g.weights.size() != m || g.types.size() != m ||
+        g.geometry.size() != m || (!ids.empty() && ids.size() != n))
+        return false;
+    for (size_t i = 0; i < n; i++)
+        if (nameOffsets[i] > nameOffsets[i + 1] || g.offsets[i] > g.offsets[i + 1])
+            return false;
+    for (size_t e = 0; e < m; e++)
+        if (g.targets[e] < 0 || g.targets[e] >= (int)n || (unsigned)g.types[e] >= (unsigned)EDGE_TYPE_COUNT ||
+            (uint64_t)g.geometry[e].start + g.geometry[e].count > pool.size())
+            return false;
+    vector<char> seen(ids.size(), 0); // load-order ids must be a permutation
+    for (int id : ids)
+        if (id < 0 || id >= (int)ids.size() || seen[id]++)
+            return false;
+
+    nodes.clear();
+    nodes.reserve(n);
+    for (size_t i = 0; i < n; i++)
+        nodes.push_back({(int)i, coords[i].lat, coords[i].lon,
+                         internName(string_view(nameBlob.data() + nameOffsets[i], nameOffsets[i + 1] - nameOffsets[i]))});
+    graph = move(g);
+    geometryPool = move(pool);
+    setOriginalIds(move(ids));
+    nodeOrder = order;
+    releaseBuildStorage();
+    dedupHead.clear();
+    dedupNext.clear();
+    publishTraffic(make_shared<TrafficOverlay>()); // a loaded graph starts without overrides
+    finalizeGraph();
+    return true;
+}
@@ -1,5 +1,6 @@
 // Solver.cpp: Pathfinding Algorithms
 #include <bits/stdc++.h>
+#include "PriorityQueue.cpp"
 using namespace std;
 
 // State for Dijkstra
@@ -9,12 +10,68 @@ struct State
     double cost, time, dist;
 };
 
-struct ParentInfo
+// Search Workspace: flat per-node arrays reused by every query on a thread.
+// A slot is live only while its stamp matches the current generation, so starting a query is O(1).
+struct SearchWorkspace
 {
-    int parent_node;
-    Edge edge_taken;
+    vector<double> dist;        // best label (distance, cost or elapsed time)
+    vector<double> arrival;     // clock time at the node (time-dependent search only)
+    vector<double> acc_cost;    // fare paid on the way to the node (time-dependent search only)
+    vector<int> parent_edge;    // edge id used to reach the node, -1 at the root
+    vector<unsigned> stamp;
+    unsigned generation = 0;
+
+    void begin()
+    {
+        size_t n = nodes.size();
+        if (stamp.size() != n)
+        {
+            dist.assign(n, INF);
+            arrival.assign(n, 0);
+            acc_cost.assign(n, 0);
+            parent_edge.assign(n, -1);
+            stamp.assign(n, 0);
+            generation = 0;
+        }
+        if (++generation == 0) // wrapped: clear stamps once every 2^32 queries
+        {
+            fill(stamp.begin(), stamp.end(), 0);
+            generation = 1;
+        }
+    }
+    double distOf(int v) const { return stamp[v] == generation ? dist[v] : INF; }
+    void set(int v, double d, int edge)
+    {
+        stamp[v] = generation;
+        dist[v] = d;
+        parent_edge[v] = edge;
+    }
 };
 
+// Two slots per thread so bidirectional searches can run both sides at once
+SearchWorkspace &threadWorkspace(int slot = 0)
+{
+    thread_local SearchWorkspace ws[2];
+    return ws[slot];
+}
+
+// Per-query lookup tables so relaxation does not touch std::map / mode lists
+unsigned modeMask(const vector<EdgeType> &modes)
+{
+    unsigned mask = 0;
+    for (auto t : modes)
+        mask |= 1u << t;
+    return mask;
+}
+
+array<double, EDGE_TYPE_COUNT> typeTable(const map<EdgeType, double> &values)
+{
+    array<double, EDGE_TYPE_COUNT> table{}; // missing types read as 0, like map::operator[]
+    for (const auto &[t, v] : values)
+        table[t] = v;
+    return table;
+}
+
 // Schedules
 struct Schedule
 {
@@ -47,7 +104,7 @@ double getWaitingTime(double current_time, EdgeType type, int problem_id)
         return INF;
 
     double elapsed = current_time - s.start;
-    double next_dep = s.start + ceil(elapsed / s.interval) * s.interval;
+    double next_dep = s.start + ceil(elapsed / s.interval - 1e-9) * s.interval; // a departure at current_time counts
 
     if (abs(next_dep - current_time) < 1e-9)
         return 0;
@@ -57,149 +114,562 @@ double getWaitingTime(double current_time, EdgeType type, int problem_id)
     return max(0.0, next_dep - current_time);
 }
 
+// Search Statistics: compiled in only with -DSEARCH_STATS; otherwise STAT(...) expands to nothing
+#ifdef SEARCH_STATS
+#define STAT(...) __VA_ARGS__
+#else
+#define STAT(...)
+#endif
+
+struct SearchStats
+{
+    long settled = 0, stale_pops = 0, pushes = 0;
+    long relaxed = 0;       // edges that passed the filters and were tried
+    long mode_filtered = 0; // edges skipped by the modes check
+    long wait_inf = 0;      // getWaitingTime calls returning INF (service closed)
+    double snap_ms = 0, search_ms = 0, path_ms = 0, export_ms = 0;
+};
+
+double msSince(chrono::steady_clock::time_point t0)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+}
+
+// One structured record per line: "[stats] key=value ..."
+string statsRecord(const string &label, const SearchStats &st)
+{
+    ostringstream out;
+    out << "[stats] " << label << " settled=" << st.settled << " stale_pops=" << st.stale_pops << " pushes=" << st.pushes
+        << " relaxed=" << st.relaxed << " mode_filtered=" << st.mode_filtered << " wait_inf=" << st.wait_inf << fixed
+        << setprecision(3) << " snap_ms=" << st.snap_ms << " search_ms=" << st.search_ms << " path_ms=" << st.path_ms
+        << " export_ms=" << st.export_ms << "\n";
+    return out.str();
+}
+
 struct SolutionPath
 {
     vector<int> nodes;
     vector<Edge> edges;
     double total_cost = 0, total_dist = 0, total_time = 0;
+    STAT(SearchStats stats;)
 };
 
-// Standard Dijkstra (Distance or Cost)
-SolutionPath dijkstra_standard(int start, int end, bool opt_cost, map<EdgeType, double> rates, vector<EdgeType> modes)
+// Static Metric: edge weight = routing weight[e] * factor[type] for every type in mask.
+// Routing weights are graph.weights unless a live traffic overlay raises them (see Traffic.cpp).
+struct Metric
 {
-    priority_queue<pair<double, int>, vector<pair<double, int>>, greater<pair<double, int>>> pq;
-    map<int, double> dist;
-    map<int, ParentInfo> parent;
+    unsigned mask;
+    array<double, EDGE_TYPE_COUNT> factor;
+    bool operator<(const Metric &o) const { return tie(mask, factor) < tie(o.mask, o.factor); }
+};
 
-    for (const auto &n : nodes)
-        dist[n.id] = INF;
-    dist[start] = 0;
-    pq.push({0, start});
+Metric makeMetric(bool opt_cost, const map<EdgeType, double> &rates, const vector<EdgeType> &modes)
+{
+    Metric m{modeMask(modes), {}};
+    if (opt_cost)
+        m.factor = typeTable(rates);
+    else
+        m.factor.fill(1.0);
+    return m;
+}
 
+// One-to-all Dijkstra over the forward graph, or the reverse graph (distances *to* src).
+// Always on base weights: traffic only raises weights, so landmark bounds built here stay admissible.
+vector<double> distancesFrom(int src, const Metric &metric, bool reverse)
+{
+    vector<double> dist(nodes.size(), INF);
+    priority_queue<pair<double, int>, vector<pair<double, int>>, greater<pair<double, int>>> pq;
+    dist[src] = 0;
+    pq.push({0, src});
+    const vector<int> &offsets = reverse ? graph.in_offsets : graph.offsets;
     while (!pq.empty())
     {
-        double d = pq.top().first;
-        int u = pq.top().second;
+        auto [d, u] = pq.top();
         pq.pop();
-
         if (d > dist[u])
             continue;
-        if (u == end)
-            break;
-
-        for (auto &e : adj[u])
+        for (int k = offsets[u]; k < offsets[u + 1]; k++)
         {
-            bool allowed = false;
-            for (auto t : modes)
-                if (e.type == t)
-                    allowed = true;
-            if (!allowed)
+            int e = reverse ? graph.in_edges[k] : k;
+            if (!(metric.mask >> graph.types[e] & 1))
                 continue;
-
-            double weight = opt_cost ? e.weight_distance * rates[e.type] : e.weight_distance;
-            if (dist[u] + weight < dist[e.to_node_id])
+            int v = reverse ? graph.sources[e] : graph.targets[e];
+            double nd = d + graph.weights[e] * metric.factor[graph.types[e]];
+            if (nd < dist[v])
             {
-                dist[e.to_node_id] = dist[u] + weight;
-                parent[e.to_node_id] = {u, e};
-                pq.push({dist[e.to_node_id], e.to_node_id});
+                dist[v] = nd;
+                pq.push({nd, v});
             }
         }
     }
+    return dist;
+}
+
+// ALT Landmarks: exact distances from/to a few far-apart nodes give triangle-inequality bounds
+struct Landmarks
+{
+    vector<int> ids;
+    vector<vector<double>> from, to; // from[k][v] = d(L_k, v), to[k][v] = d(v, L_k)
+};
+map<Metric, Landmarks> landmarkCache;
+mutex landmarkMutex;
+
+// Farthest-point selection: each new landmark is the reachable node farthest from those chosen so far
+const Landmarks &buildLandmarks(const Metric &metric, int count = 8)
+{
+    lock_guard<mutex> lock(landmarkMutex);
+    auto it = landmarkCache.find(metric);
+    if (it != landmarkCache.end())
+        return it->second;
+
+    Landmarks lm;
+    vector<double> closest(nodes.size(), INF);
+    int next = -1;
+    vector<double> seed = nodes.empty() ? vector<double>() : distancesFrom(0, metric, false);
+    double far = -1;
+    for (size_t v = 0; v < seed.size(); v++)
+        if (seed[v] < INF && seed[v] > far)
+            far = seed[v], next = (int)v;
+
+    while (next != -1 && (int)lm.ids.size() < count)
+    {
+        lm.ids.push_back(next);
+        lm.from.push_back(distancesFrom(next, metric, false));
+        lm.to.push_back(distancesFrom(next, metric, true));
+
+        next = -1;
+        far = 0;
+        for (size_t v = 0; v < nodes.size(); v++)
+        {
+            closest[v] = min(closest[v], lm.from.back()[v]);
+            if (closest[v] < INF && closest[v] > far)
+                far = closest[v], next = (int)v;
+        }
+    }
+    return landmarkCache[metric] = move(lm);
+}
+
+// Goal-Directed Search
+enum SearchMode
+{
+    SEARCH_DIJKSTRA,
+    SEARCH_ASTAR, // haversine lower bound
+    SEARCH_ALT    // landmark lower bound
+};
+
+// Lower bound on the remaining weight from v to target (0 for plain Dijkstra)
+struct Potential
+{
+    SearchMode mode = SEARCH_DIJKSTRA;
+    int target = -1;
+    double scale = 0; // A*: weight per straight-line km
+    const Landmarks *lm = nullptr;
+
+    double operator()(int v) const
+    {
+        if (mode == SEARCH_ASTAR)
+            return scale * getDistance(nodes[v].lat, nodes[v].lon, nodes[target].lat, nodes[target].lon);
+        if (mode != SEARCH_ALT)
+            return 0;
+        double h = 0;
+        for (size_t k = 0; k < lm->ids.size(); k++)
+        {
+            const vector<double> &from = lm->from[k], &to = lm->to[k];
+            if (from[target] < INF && from[v] < INF)
+                h = max(h, from[target] - from[v]);
+            if (to[v] < INF && to[target] < INF)
+                h = max(h, to[v] - to[target]);
+        }
+        return h;
+    }
+};
+
+Potential makePotential(SearchMode mode, const Metric &metric, int target)
+{
+    Potential p;
+    p.mode = mode;
+    p.target = target;
+    if (mode == SEARCH_ASTAR)
+    {
+        // Cheapest allowed type per straight-line km; shaved slightly so rounding cannot overestimate
+        p.scale = INF;
+        for (int t = 0; t < EDGE_TYPE_COUNT; t++)
+            if (metric.mask >> t & 1)
+                p.scale = min(p.scale, metric.factor[t] * graph.min_stretch[t]);
+        p.scale = (p.scale == INF) ? 0 : max(0.0, p.scale * (1 - 1e-9));
+    }
+    else if (mode == SEARCH_ALT)
+        p.lm = &buildLandmarks(metric);
+    return p;
+}
+
+// Queue defaults, picked with bench (~20-30% under LazyHeap on the seeded workload). Both stay exact:
+// RadixHeap pops keys equal after scaling in any order, so stopping at the target could report a label
+// up to 1/scale above the optimum; bench still runs it as the radix rows.
+typedef QuadHeap StaticQueue;
+typedef QuadHeap TimeQueue;
+
+// Graph edges of the search-tree path from start to v, last edge first. Parent codes are search arcs,
+// -2 - i for the query's chain slice i, and -1 at the root.
+vector<int> searchTreeEdges(const SearchWorkspace &ws, int start, int v, const vector<ChainSlice> &slices)
+{
+    vector<int> edges;
+    while (v != start)
+    {
+        int code = ws.parent_edge[v], count;
+        const int *part = code >= 0 ? arcEdges(code, count) : slices[-2 - code].edges();
+        if (code < 0)
+            count = slices[-2 - code].count();
+        for (int i = count; i-- > 0;)
+            edges.push_back(part[i]);
+        v = graph.sources[part[0]];
+    }
+    return edges;
+}
+
+// Standard Dijkstra (Distance or Cost)
+// search = SEARCH_ASTAR / SEARCH_ALT orders the queue by dist + lower bound; paths stay optimal.
+// Runs on the chain-compressed search graph; a chain is relaxed edge by edge, so labels match the full graph.
+template <typename Queue = StaticQueue>
+SolutionPath dijkstra_standard(int start, int end, bool opt_cost, map<EdgeType, double> rates, vector<EdgeType> modes,
+                               SearchMode search = SEARCH_DIJKSTRA)
+{
+    thread_local Queue pq;
+    pq.clear();
+    SearchWorkspace &ws = threadWorkspace();
+    Metric metric = makeMetric(opt_cost, rates, modes);
+    Potential h = makePotential(search, metric, end);
+    auto rate = typeTable(rates);
+    auto traffic = currentTraffic(); // held for the whole query so a concurrent update cannot swap it mid-search
+    const vector<double> &weights = traffic->routingWeights();
+    const SearchGraph &sg = searchGraph;
+    vector<ChainSlice> slices = endpointSlices(start, end);
+    STAT(SearchStats stats; auto t0 = chrono::steady_clock::now();)
+
+    // One arc out of u: the graph edges [edges, edges + count), all of one type
+    auto relax = [&](double du, EdgeType type, const int *edges, int count, int code)
+    {
+        if (!(metric.mask >> type & 1))
+        {
+            STAT(stats.mode_filtered++;)
+            return;
+        }
+        STAT(stats.relaxed++;)
+
+        double nd = du;
+        for (int i = 0; i < count; i++)
+        {
+            if (weights[edges[i]] == INF) // closed by a traffic override
+                return;
+            nd += weights[edges[i]] * metric.factor[type];
+        }
+        int v = graph.targets[edges[count - 1]];
+        if (nd < ws.distOf(v))
+        {
+            ws.set(v, nd, code);
+            pq.push(nd + h(v), v);
+            STAT(stats.pushes++;)
+        }
+    };
+
+    ws.begin();
+    ws.set(start, 0, -1);
+    pq.push(h(start), start);
+    STAT(stats.pushes++;)
+
+    while (!pq.empty())
+    {
+        auto [d, u] = pq.pop();
+
+        double du = ws.dist[u];
+        if (d > du + h(u))
+        {
+            STAT(stats.stale_pops++;)
+            continue;
+        }
+        STAT(stats.settled++;)
+        if (u == end)
+            break;
+
+        for (int k = sg.offsets[u]; k < sg.offsets[u + 1]; k++)
+        {
+            int count;
+            const int *edges = arcEdges(k, count);
+            relax(du, sg.types[k], edges, count, k);
+        }
+        for (size_t i = 0; i < slices.size(); i++)
+            if (slices[i].tail() == u)
+                relax(du, graph.types[slices[i].edges()[0]], slices[i].edges(), slices[i].count(), -2 - (int)i);
+    }
+    STAT(stats.search_ms = msSince(t0); t0 = chrono::steady_clock::now();)
 
     SolutionPath path;
-    if (dist[end] == INF)
+    if (ws.distOf(end) == INF)
+    {
+        STAT(path.stats = stats;)
         return path;
+    }
 
-    for (int v = end; v != start; v = parent[v].parent_node)
+    for (int id : searchTreeEdges(ws, start, end, slices))
     {
-        path.nodes.push_back(v);
-        path.edges.push_back(parent[v].edge_taken);
-        path.total_dist += parent[v].edge_taken.weight_distance;
-        path.total_cost += parent[v].edge_taken.weight_distance * rates[parent[v].edge_taken.type];
+        Edge e = getEdge(id);
+        path.nodes.push_back(graph.targets[id]);
+        path.total_dist += e.weight_distance;
+        path.total_cost += e.weight_distance * rate[e.type];
+        path.edges.push_back(move(e));
     }
     path.nodes.push_back(start);
     reverse(path.nodes.begin(), path.nodes.end());
     reverse(path.edges.begin(), path.edges.end());
+    STAT(stats.path_ms = msSince(t0); path.stats = stats;)
     return path;
 }
 
-// Time-Dependent Dijkstra (Cost or Time)
-// Target: 0 = Cost, 1 = Time
-SolutionPath dijkstra_time_dependent(int start, int end, double start_time, int target, map<EdgeType, double> rates, map<EdgeType, double> speeds, vector<EdgeType> modes, int pid)
+// Assemble a SolutionPath from the graph edges walked from start, in travel order
+SolutionPath pathFromEdges(int start, const vector<int> &edge_ids, const array<double, EDGE_TYPE_COUNT> &rate)
 {
-    struct State
+    SolutionPath path;
+    path.nodes.push_back(start);
+    for (int e : edge_ids)
     {
-        double val;
-        int u;
-        double curr_time, acc_cost;
-        bool operator>(const State &o) const { return val > o.val; }
-    };
-
-    priority_queue<State, vector<State>, greater<State>> pq;
-    map<int, double> best;
-    map<int, ParentInfo> parent;
-    map<int, double> arrival;
-
-    for (const auto &n : nodes)
-        best[n.id] = INF;
-    best[start] = 0;
-    pq.push({0, start, start_time, 0});
-    arrival[start] = start_time;
+        Edge edge = getEdge(e);
+        path.nodes.push_back(edge.to_node_id);
+        path.total_dist += edge.weight_distance;
+        path.total_cost += edge.weight_distance * rate[edge.type];
+        path.edges.push_back(move(edge));
+    }
+    return path;
+}
 
-    while (!pq.empty())
+// Bidirectional Dijkstra (Distance or Cost)
+// Forward search over graph.offsets from start, backward over the reverse view (in_edges) from end.
+// Stops once the two queue minima together reach the best meeting distance; no symmetry is assumed.
+template <typename Queue = StaticQueue>
+SolutionPath dijkstra_bidirectional(int start, int end, bool opt_cost, map<EdgeType, double> rates, vector<EdgeType> modes)
+{
+    Metric metric = makeMetric(opt_cost, rates, modes);
+    auto traffic = currentTraffic();
+    const vector<double> &weights = traffic->routingWeights();
+    SearchWorkspace *ws[2] = {&threadWorkspace(0), &threadWorkspace(1)};
+    thread_local Queue pq[2];
+    pq[0].clear();
+    pq[1].clear();
+
+    ws[0]->begin();
+    ws[1]->begin();
+    ws[0]->set(start, 0, -1);
+    ws[1]->set(end, 0, -1);
+    pq[0].push(0, start);
+    pq[1].push(0, end);
+    double best = (start == end) ? 0 : INF;
+    int meet = (start == end) ? start : -1;
+
+    while (!pq[0].empty() && !pq[1].empty() && pq[0].minKey() + pq[1].minKey() < best)
     {
-        State top = pq.top();
-        pq.pop();
-
-        if (top.val > best[top.u])
+        int side = pq[0].minKey() <= pq[1].minKey() ? 0 : 1;
+        SearchWorkspace &self = *ws[side], &other = *ws[1 - side];
+        auto [d, u] = pq[side].pop();
+        if (d > self.dist[u])
             continue;
-        if (top.u == end)
-            break;
 
-        for (auto &e : adj[top.u])
+        const vector<int> &offsets = side == 0 ? graph.offsets : graph.in_offsets;
+        for (int k = offsets[u]; k < offsets[u + 1]; k++)
         {
-            bool allowed = false;
-            for (auto t : modes)
-                if (e.type == t)
-                    allowed = true;
-            if (!allowed)
+            int e = side == 0 ? k : graph.in_edges[k];
+            EdgeType type = graph.types[e];
+            if (!(metric.mask >> type & 1))
                 continue;
 
-            double wait = getWaitingTime(top.curr_time, e.type, pid);
-            if (wait == INF)
+            if (weights[e] == INF)
                 continue;
+            int v = side == 0 ? graph.targets[e] : graph.sources[e];
+            double nd = d + weights[e] * metric.factor[type];
+            if (nd < self.distOf(v))
+            {
+                self.set(v, nd, e);
+                pq[side].push(nd, v);
+            }
+            double through = self.distOf(v) + other.distOf(v);
+            if (through < best)
+            {
+                best = through;
+                meet = v;
+            }
+        }
+    }
 
-            double travel = 0;
-            if (e.type == WALKING)
-                travel = e.weight_distance / 2.0;
-            else if (speeds[e.type] > 0)
-                travel = e.weight_distance / speeds[e.type];
+    if (meet == -1)
+        return SolutionPath();
 
-            double next_time = top.curr_time + wait + travel;
-            double next_cost = top.acc_cost + e.weight_distance * rates[e.type];
-            double new_val = (target == 0) ? next_cost : (next_time - start_time);
+    vector<int> edge_ids;
+    for (int v = meet; v != start; v = graph.sources[ws[0]->parent_edge[v]])
+        edge_ids.push_back(ws[0]->parent_edge[v]);
+    reverse(edge_ids.begin(), edge_ids.end());
+    for (int v = meet; v != end; v = graph.targets[ws[1]->parent_edge[v]])
+        edge_ids.push_back(ws[1]->parent_edge[v]);
+    return pathFromEdges(start, edge_ids, typeTable(rates));
+}
 
-            if (new_val < best[e.to_node_id])
+// Time-Dependent Sweep: label-setting search from start left in threadWorkspace() (dist = objective,
+// arrival = clock time, acc_cost = fare so far). Stops after settling end (-1 = none) or once the
+// objective passes limit. Runs on the chain-compressed search graph; a full sweep (end = -1) then
+// labels the interior chain nodes too, without parents. slices receives the query's chain slices,
+// which the parent codes refer to. -DSEARCH_STATS builds take a trailing SearchStats to count into.
+// Target: 0 = Cost, 1 = Time (elapsed hours)
+template <typename Queue = TimeQueue>
+SearchWorkspace &timeDependentSweep(int start, double start_time, int target, const array<double, EDGE_TYPE_COUNT> &rate,
+                                    const array<double, EDGE_TYPE_COUNT> &speed, unsigned mask, int pid, int end,
+                                    double limit, vector<ChainSlice> &slices STAT(, SearchStats &stats))
+{
+    thread_local Queue pq;
+    pq.clear();
+    SearchWorkspace &ws = threadWorkspace();
+    auto traffic = currentTraffic();
+    const SearchGraph &sg = searchGraph;
+    slices = endpointSlices(start, end);
+
+    // Clock and fare after taking edges [edges, edges + count) of one type from (time, cost); false if blocked
+    auto advance = [&](const int *edges, int count, EdgeType type, double &time, double &cost)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            int e = edges[i];
+            double wait = getWaitingTime(time, type, pid);
+            if (wait == INF)
             {
-                best[e.to_node_id] = new_val;
-                parent[e.to_node_id] = {top.u, e};
-                arrival[e.to_node_id] = next_time;
-                pq.push({new_val, e.to_node_id, next_time, next_cost});
+                STAT(stats.wait_inf++;)
+                return false;
             }
+            if (traffic->closed(e))
+                return false;
+
+            // Cost stays per physical km; live speed overrides only change how long the edge takes
+            double w = graph.weights[e];
+            double v_kmh = traffic->speed(e, type == WALKING ? 2.0 : speed[type]);
+            double travel = v_kmh > 0 ? w / v_kmh : 0;
+            time = time + wait + travel;
+            cost = cost + w * rate[type];
+        }
+        return true;
+    };
+    auto relax = [&](int u, EdgeType type, const int *edges, int count, int code)
+    {
+        if (!(mask >> type & 1))
+        {
+            STAT(stats.mode_filtered++;)
+            return;
+        }
+        double next_time = ws.arrival[u], next_cost = ws.acc_cost[u];
+        if (!advance(edges, count, type, next_time, next_cost))
+            return;
+        STAT(stats.relaxed++;)
+
+        int v = graph.targets[edges[count - 1]];
+        double new_val = (target == 0) ? next_cost : (next_time - start_time);
+
+        // Labels past the limit are never settled, so they need not be queued either
+        if (new_val < ws.distOf(v) && new_val <= limit)
+        {
+            ws.set(v, new_val, code);
+            ws.arrival[v] = next_time;
+            ws.acc_cost[v] = next_cost;
+            pq.push(new_val, v);
+            STAT(stats.pushes++;)
+        }
+    };
+
+    ws.begin();
+    ws.set(start, 0, -1);
+    ws.arrival[start] = start_time;
+    ws.acc_cost[start] = 0;
+    pq.push(0, start);
+    STAT(stats.pushes++;)
+
+    while (!pq.empty())
+    {
+        auto [val, u] = pq.pop();
+        if (val > ws.dist[u])
+        {
+            STAT(stats.stale_pops++;)
+            continue;
+        }
+        STAT(stats.settled++;)
+        if (u == end)
+            break;
+
+        for (int k = sg.offsets[u]; k < sg.offsets[u + 1]; k++)
+        {
+            int count;
+            const int *edges = arcEdges(k, count);
+            relax(u, sg.types[k], edges, count, k);
         }
+        for (size_t i = 0; i < slices.size(); i++)
+            if (slices[i].tail() == u)
+                relax(u, graph.types[slices[i].edges()[0]], slices[i].edges(), slices[i].count(), -2 - (int)i);
     }
+    if (end != -1)
+        return ws;
+
+    // Interior nodes take the better of the labels carried in from either end of their chain (or from
+    // start, when it is interior itself)
+    auto fill = [&](int c, int from)
+    {
+        const int *edges = &sg.chainEdges[sg.chainStart[c]];
+        int u = graph.sources[edges[from]];
+        EdgeType type = graph.types[edges[0]];
+        if (ws.distOf(u) == INF || !(mask >> type & 1))
+            return;
+        double time = ws.arrival[u], cost = ws.acc_cost[u];
+        for (int i = from; i + 1 < sg.chainLength(c); i++)
+        {
+            if (!advance(edges + i, 1, type, time, cost))
+                return;
+            int v = graph.targets[edges[i]];
+            double val = (target == 0) ? cost : (time - start_time);
+            if (val > limit)
+                return;
+            if (val < ws.distOf(v))
+            {
+                ws.set(v, val, -1);
+                ws.arrival[v] = time;
+                ws.acc_cost[v] = cost;
+            }
+        }
+    };
+    for (int c = 0; c + 1 < (int)sg.chainStart.size(); c++)
+        fill(c, 0);
+    if (sg.interior(start))
+        for (int side = 0; side < 2; side++)
+            fill(sg.through[start][side], sg.pos[start][side]);
+    return ws;
+}
+
+// Time-Dependent Dijkstra (Cost or Time)
+// Target: 0 = Cost, 1 = Time
+template <typename Queue = TimeQueue>
+SolutionPath dijkstra_time_dependent(int start, int end, double start_time, int target, map<EdgeType, double> rates, map<EdgeType, double> speeds, vector<EdgeType> modes, int pid)
+{
+    auto rate = typeTable(rates);
+    vector<ChainSlice> slices;
+    STAT(SearchStats stats; auto t0 = chrono::steady_clock::now();)
+    SearchWorkspace &ws = timeDependentSweep<Queue>(start, start_time, target, rate, typeTable(speeds), modeMask(modes), pid, end,
+                                                    INF, slices STAT(, stats));
+    STAT(stats.search_ms = msSince(t0); t0 = chrono::steady_clock::now();)
 
     SolutionPath path;
-    if (best[end] == INF)
+    if (ws.distOf(end) == INF)
+    {
+        STAT(path.stats = stats;)
         return path;
+    }
 
-    path.total_cost = (target == 0) ? best[end] : 0;
-    path.total_time = arrival[end] - start_time;
+    path.total_cost = (target == 0) ? ws.dist[end] : 0;
+    path.total_time = ws.arrival[end] - start_time;
 
-    for (int v = end; v != start; v = parent[v].parent_node)
+    for (int id : searchTreeEdges(ws, start, end, slices))
     {
-        path.nodes.push_back(v);
-        path.edges.push_back(parent[v].edge_taken);
+        path.nodes.push_back(graph.targets[id]);
+        path.edges.push_back(getEdge(id));
     }
     path.nodes.push_back(start);
     reverse(path.nodes.begin(), path.nodes.end());
@@ -209,32 +679,31 @@ SolutionPath dijkstra_time_dependent(int start, int end, double start_time, int
     {
         path.total_cost = 0;
         for (auto &e : path.edges)
-            path.total_cost += e.weight_distance * rates[e.type];
+            path.total_cost += e.weight_distance * rate[e.type];
     }
     for (auto &e : path.edges)
         path.total_dist += e.weight_distance;
+    STAT(stats.path_ms = msSince(t0); path.stats = stats;)
     return path;
 }
 
 
 // Output
+// Clock time for h hours after midnight of the start day; times on later days get a "+Nd" marker
 string formatTime(double h)
 {
-    int hr = (int)h;
-    int mn = (int)((h - hr) * 60 + 0.5);
-    string suff = "AM";
-    if (hr >= 12)
-    {
-        suff = "PM";
-        if (hr > 12)
-            hr -= 12;
-    }
+    long total = lround(h * 60); // rounded as a whole, so 5:59.7 shows as 6:00 rather than 5:60
+    long day = total >= 0 ? total / (24 * 60) : 0;
+    int mins = (int)(total - day * 24 * 60);
+    int hr = mins / 60, mn = mins % 60;
+    string suff = hr >= 12 ? "PM" : "AM";
+    hr %= 12;
     if (hr == 0)
         hr = 12;
-    if (hr > 12)
-        hr -= 12;
     stringstream ss;
     ss << hr << ":" << setfill('0') << setw(2) << mn << " " << suff;
+    if (day > 0)
+        ss << " +" << day << "d";
     return ss.str();
 }
 
@@ -256,8 +725,8 @@ void printPathDescription(SolutionPath path, double start_hour, map<EdgeType, do
     {
         Edge e = path.edges[i];
         string name = getEdgeTypeName(e.type);
-        string from = nodes[path.nodes[i]].name.empty() ? "RoadIntersection" : nodes[path.nodes[i]].name;
-        string to = nodes[path.nodes[i + 1]].name.empty() ? "RoadIntersection" : nodes[path.nodes[i + 1]].name;
+        string from = nodes[path.nodes[i]].name.empty() ? "RoadIntersection" : string(nodes[path.nodes[i]].name);
+        string to = nodes[path.nodes[i + 1]].name.empty() ? "RoadIntersection" : string(nodes[path.nodes[i + 1]].name);
 
         double wait = 0, travel = 0, cost = e.weight_distance * rates[e.type];
         if (start_hour >= 0)
@@ -292,8 +761,11 @@ void exportKML(SolutionPath path, string file, string color)
     kml << "<Style id=\"p\"><LineStyle><color>" << color << "</color><width>4</width></LineStyle></Style>\n";
     kml << "<Placemark><name>Route</name><styleUrl>#p</styleUrl><LineString><tessellate>1</tessellate><coordinates>\n";
     for (auto &e : path.edges)
-        for (auto &p : e.geometry)
+        for (size_t i = 0; i < e.geometry.size(); i++)
+        {
+            Point p = e.geometry[i];
             kml << fixed << setprecision(6) << p.lon << "," << p.lat << ",0\n";
+        }
     kml << "</coordinates></LineString></Placemark></Document></kml>";
     kml.close();
     cout << "Exported " << file << endl;
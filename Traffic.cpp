@@ -0,0 +1,138 @@
+// Traffic.cpp: Live Traffic Overrides
+// Batches of per-edge overrides are applied to a copy of the current overlay; the hierarchies cached
+// for every metric are re-customized against it, and both are published together; the transit network
+// is dropped so its transfer walks are rebuilt around closures. Queries already running keep the
+// overlay, hierarchy and network they started with.
+#include <bits/stdc++.h>
+using namespace std;
+
+enum TrafficKind
+{
+    TRAFFIC_SPEED,  // km/h for time-dependent travel (P4 / P5); routing weights untouched
+    TRAFFIC_FACTOR, // multiplies the static routing weight; >= 1 so A* / ALT bounds stay admissible
+    TRAFFIC_CLOSED, // edge unusable by every solver
+    TRAFFIC_CLEAR   // drop all overrides on the edge
+};
+
+struct TrafficUpdate
+{
+    int from, to; // applies to every edge from -> to
+    TrafficKind kind;
+    double value = 0;
+};
+
+// Feed: one "<from_node> <to_node> speed <kmh> | factor <x> | closed | clear" per line; '#' comments.
+// Node ids are the load-order ones printed by the other modes.
+vector<TrafficUpdate> readTrafficFeed(istream &in)
+{
+    vector<TrafficUpdate> updates;
+    string line;
+    for (int lineNo = 1; getline(in, line); lineNo++)
+    {
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == string::npos || line[first] == '#')
+            continue;
+        TrafficUpdate u;
+        string kind;
+        istringstream ss(line);
+        if (!(ss >> u.from >> u.to >> kind))
+            throw invalid_argument("traffic line " + to_string(lineNo) + ": expected <from> <to> <kind> [value]");
+        if (u.from < 0 || u.to < 0 || u.from >= (int)nodes.size() || u.to >= (int)nodes.size())
+            throw invalid_argument("traffic line " + to_string(lineNo) + ": node id out of range");
+        u.from = nodeOfOriginalId(u.from);
+        u.to = nodeOfOriginalId(u.to);
+
+        if (kind == "speed" || kind == "factor")
+        {
+            u.kind = kind == "speed" ? TRAFFIC_SPEED : TRAFFIC_FACTOR;
+            if (!(ss >> u.value) || (u.kind == TRAFFIC_SPEED ? u.value <= 0 : u.value < 1))
+                throw invalid_argument("traffic line " + to_string(lineNo) + ": " + kind +
+                                       (u.kind == TRAFFIC_SPEED ? " needs a value > 0" : " needs a value >= 1"));
+        }
+        else if (kind == "closed")
+            u.kind = TRAFFIC_CLOSED;
+        else if (kind == "clear")
+            u.kind = TRAFFIC_CLEAR;
+        else
+            throw invalid_argument("traffic line " + to_string(lineNo) + ": unknown kind '" + kind + "'");
+        updates.push_back(u);
+    }
+    return updates;
+}
+
+struct TrafficReport
+{
+    uint64_t version = 0;
+    int edges = 0;      // edge overrides written
+    int unmatched = 0;  // updates naming a pair with no edge between them
+    int hierarchies = 0;
+    double customize_ms = 0;
+};
+
+// Apply one batch atomically: later lines win over earlier ones for the same edge
+TrafficReport applyTrafficUpdates(const vector<TrafficUpdate> &updates)
+{
+    TrafficReport report;
+    lock_guard<mutex> lock(chMutex); // serializes writers and keeps the cache in step with the overlay
+    auto next = make_shared<TrafficOverlay>(*currentTraffic());
+    next->version++;
+    size_t m = graph.targets.size();
+    if (next->weights.empty())
+        next->weights = graph.weights;
+    if (next->speeds.empty())
+        next->speeds.assign(m, 0);
+
+    for (const auto &u : updates)
+    {
+        bool matched = false;
+        for (int e = graph.offsets[u.from]; e < graph.offsets[u.from + 1]; e++)
+        {
+            if (graph.targets[e] != u.to)
+                continue;
+            matched = true;
+            report.edges++;
+            switch (u.kind)
+            {
+            case TRAFFIC_SPEED:
+                next->speeds[e] = (float)u.value;
+                break;
+            case TRAFFIC_FACTOR:
+                next->weights[e] = graph.weights[e] * u.value;
+                break;
+            case TRAFFIC_CLOSED:
+                next->weights[e] = INF;
+                break;
+            case TRAFFIC_CLEAR:
+                next->weights[e] = graph.weights[e];
+                next->speeds[e] = 0;
+                break;
+            }
+        }
+        report.unmatched += !matched;
+    }
+
+    auto t0 = chrono::steady_clock::now();
+    map<Metric, shared_ptr<const ContractionHierarchy>> customized;
+    for (const auto &[metric, ch] : chCache)
+        if (ch)
+            customized[metric] = customizeHierarchy(metric, *next);
+    report.customize_ms = msSince(t0);
+    report.hierarchies = (int)customized.size();
+    report.version = next->version;
+
+    publishTraffic(next);
+    chCache.swap(customized);
+    clearTransitNetwork(); // after publishing, so a rebuild already in flight is discarded
+    return report;
+}
+
+TrafficReport applyTrafficFeed(istream &in) { return applyTrafficUpdates(readTrafficFeed(in)); }
+
+void printTrafficReport(const TrafficReport &r)
+{
+    cout << "Traffic v" << r.version << ": " << r.edges << " edge overrides";
+    if (r.unmatched)
+        cout << ", " << r.unmatched << " updates without a matching edge";
+    cout << "; " << r.hierarchies << " hierarchies customized in " << fixed << setprecision(1) << r.customize_ms
+         << " ms" << endl;
+}